@@ -0,0 +1,140 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/baseline.h"
+
+#include <stdio.h>
+#include <map>
+#include <tuple>
+
+#include "src/backend.h"
+
+using namespace megpeak;
+
+namespace {
+using Key = std::tuple<std::string, std::string, std::string>;
+
+Key get_key(const ResultRecord& record) {
+    return Key{record.suite, record.name, record.metric};
+}
+
+//! 1 if a larger value is better, -1 if a smaller one is, 0 if unknown
+int get_direction(const std::string& unit) {
+    for (auto&& lower : {"ns", "cycle", "tick"}) {
+        if (unit == lower) {
+            return -1;
+        }
+    }
+    for (auto&& higher : {"GFlops", "Ginst/s", "GiB/s", "GB/s"}) {
+        if (unit == higher) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void print_env_diff(const char* name, const std::string& baseline,
+                    const std::string& current) {
+    if (baseline != current) {
+        printf("    %s: %s -> %s\n", name, baseline.c_str(), current.c_str());
+    }
+}
+}  // namespace
+
+void megpeak::save_baseline(const ResultSink& sink, const std::string& path) {
+    sink.write(ResultSink::Format::CSV, path);
+    printf("baseline of %zu metrics saved to %s\n", sink.records().size(),
+           path.c_str());
+}
+
+size_t megpeak::compare_baseline(const ResultSink& sink,
+                                 const std::string& path, double threshold) {
+    Environment env;
+    std::vector<ResultRecord> baseline;
+    megpeak_assert(load_results(path, env, baseline),
+                   "can not load baseline %s", path.c_str());
+    std::map<Key, const ResultRecord*> baseline_records;
+    for (auto&& record : baseline) {
+        baseline_records[get_key(record)] = &record;
+    }
+
+    auto&& current = sink.environment();
+    printf("\ncompare with baseline %s, regression threshold %.1f%%\n",
+           path.c_str(), threshold * 100);
+    if (env.cpu_model != current.cpu_model ||
+        env.kernel_version != current.kernel_version ||
+        env.compiler != current.compiler ||
+        env.build_flags != current.build_flags) {
+        printf("environment changed since the baseline:\n");
+        print_env_diff("cpu model", env.cpu_model, current.cpu_model);
+        print_env_diff("kernel", env.kernel_version, current.kernel_version);
+        print_env_diff("compiler", env.compiler, current.compiler);
+        print_env_diff("build flags", env.build_flags, current.build_flags);
+    }
+    printf("%-16s %-28s %-20s %14s %14s %9s  %s\n", "suite", "name", "metric",
+           "baseline mean", "current mean", "change", "status");
+
+    size_t nr_compared = 0, nr_improved = 0, nr_regressed = 0,
+           nr_untested = 0;
+    for (auto&& record : sink.records()) {
+        auto iter = baseline_records.find(get_key(record));
+        if (iter == baseline_records.end()) {
+            continue;
+        }
+        auto&& base = iter->second->stats;
+        auto&& stats = record.stats;
+        //! the t-test is on the means, so is the change
+        double change =
+                base.mean != 0 ? (stats.mean - base.mean) / base.mean : 0;
+        int direction = get_direction(record.unit);
+        bool testable = is_testable(base, stats);
+        const char* status = "ok";
+        if (direction == 0) {
+            status = "-";
+        } else if (!testable) {
+            //! a single value has no spread to test, the threshold alone
+            //! flags it but it does not fail the comparison
+            if (change * direction < -threshold) {
+                status = "worse (single value, untested)";
+                nr_untested++;
+            } else if (change * direction > threshold) {
+                status = "better (single value, untested)";
+            }
+        } else if (!is_significant(base, stats)) {
+            status = "not significant";
+        } else if (change * direction < -threshold) {
+            status = "REGRESSION";
+            nr_regressed++;
+        } else if (change * direction > threshold) {
+            status = "improved";
+            nr_improved++;
+        }
+        nr_compared++;
+        printf("%-16s %-28s %-20s %14.6g %14.6g %+8.2f%%  %s\n",
+               record.suite.c_str(), record.name.c_str(),
+               record.metric.c_str(), base.mean, stats.mean, change * 100,
+               status);
+        baseline_records.erase(iter);
+    }
+    printf("%zu metrics compared, %zu improved, %zu regressed", nr_compared,
+           nr_improved, nr_regressed);
+    if (nr_untested) {
+        printf(", %zu single values worse beyond the threshold", nr_untested);
+    }
+    if (!baseline_records.empty()) {
+        printf(", %zu metrics of the baseline are not run",
+               baseline_records.size());
+    }
+    printf("\n");
+    return nr_regressed;
+}
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,41 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+#pragma once
+
+#include <string>
+
+#include "src/report.h"
+
+namespace megpeak {
+
+//! save the results of the run as the baseline, in the csv result format
+void save_baseline(const ResultSink& sink, const std::string& path);
+
+/**
+ * \brief compare the results of the run with a saved baseline
+ *
+ * every metric found in both is printed with the relative change of its
+ * mean. A change is significant if welch's t-test on the samples of the two
+ * runs rejects equal means, see is_significant(). A metric regresses if the
+ * change is significant, makes it worse and is larger than \p threshold
+ * (relative, e.g. 0.02), lower is better for times/cycles and higher is
+ * better for bandwidth/flops, the pmu event counts are only printed. The
+ * metrics reported as a single value can not be tested, a change beyond the
+ * threshold is printed as such but is not a regression.
+ *
+ * \return the number of the regressed metrics
+ */
+size_t compare_baseline(const ResultSink& sink, const std::string& path,
+                        double threshold);
+
+}  // namespace megpeak
+
+// vim: syntax=cpp.doxygen
@@ -12,77 +12,191 @@
 #include "src/cpu/aarch64.h"
 #include "src/cpu/aarch64_dual_issue.h"
 #include "src/cpu/common.h"
+#include "src/cpu/registry.h"
 
 #if MEGPEAK_AARCH64
 // clang-format on
 
-void megpeak::aarch64() {
-  //! warmup
-  for (size_t i = 0; i < 100; i++) {
-    fmla_throughput();
-  }
-#if MEGPEAK_WITH_ALL_BENCHMARK
-  benchmark(nop_throughput, nop_latency, "nop", 1);
-#endif
-  benchmark(ldd_throughput, ldd_latency, "ldd", 2);
-  benchmark(ldq_throughput, ldq_latency, "ldq", 4);
-  benchmark(stq_throughput, stq_latency, "stq", 4);
-  benchmark(ldpq_throughput, ldpq_latency, "ldpq", 8);
-  benchmark(lddx2_throughput, lddx2_latency, "lddx2", 4);
-  benchmark(ld1q_throughput, ld1q_latency, "ld1q", 4);
-
-  benchmark(eor_throughput, eor_latency, "eor", 4);
-  benchmark(fmla_throughput, fmla_latency, "fmla", 8);
-  benchmark(fmlad_throughput, fmlad_latency, "fmlad", 4);
-  benchmark(fmla_x2_throughput, fmla_x2_latency, "fmla_x2", 16);
-  benchmark(mla_throughput, mla_latency, "mla", 8);
-  benchmark(fmul_throughput, fmul_latency, "fmul");
-  benchmark(mul_throughput, mul_latency, "mul");
-  benchmark(addp_throughput, addp_latency, "addp");
-
+MEGPEAK_REGISTER_BENCHMARK(aarch64, nop, "nop", "", nullptr, 1, "extended")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldd, "ldd", "", nullptr, 2, "load_store")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldq, "ldq", "", nullptr, 4, "load_store")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, stq, "stq", "", nullptr, 4, "load_store")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldpq, "ldpq", "", nullptr, 8, "load_store")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, lddx2, "lddx2", "", nullptr, 4,
+                           "load_store")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ld1q, "ld1q", "", nullptr, 4, "load_store")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, eor, "eor", "", nullptr, 4, "logic")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, fmla, "fmla", "", nullptr, 8, "fp32")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, fmlad, "fmlad", "", nullptr, 4, "fp32")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, fmla_x2, "fmla_x2", "", nullptr, 16, "fp32")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, mla, "mla", "", nullptr, 8, "int32")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, fmul, "fmul", "", nullptr, 4, "fp32")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, mul, "mul", "", nullptr, 4, "int32")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, addp, "addp", "", nullptr, 4, "int32")
 #if __ARM_FEATURE_DOTPROD
-  benchmark(sdot_throughput, sdot_latency, "sdot", 32);
+MEGPEAK_REGISTER_BENCHMARK(aarch64, sdot, "sdot", "dotprod", nullptr, 32,
+                           "int8")
 #endif
 #ifdef MEGPEAK_ENABLE_MMA
-  benchmark(smmla_throughput, smmla_latency, "smmla", 64);
+MEGPEAK_REGISTER_BENCHMARK(aarch64, smmla, "smmla", "i8mm", nullptr, 64, "int8")
 #endif
 #ifdef MEGPEAK_ENABLE_BFMMA
-  benchmark(bfmmla_throughput, bfmmla_latency, "bfmmla", 32);
+MEGPEAK_REGISTER_BENCHMARK(aarch64, bfmmla, "bfmmla", "bf16", nullptr, 32,
+                           "bf16")
 #endif
-  benchmark(sadalp_throughput, sadalp_latency, "sadalp");
-  benchmark(add_throughput, add_latency, "add");
-  benchmark(fadd_throughput, fadd_latency, "fadd");
-  benchmark(smull_throughput, smull_latency, "smull");
-  benchmark(smlal_throughput, smlal_latency, "smlal_4b", 8);
-
-  benchmark(smlal_8b_throughput, smlal_8b_latency, "smlal_8b", 16);
+MEGPEAK_REGISTER_BENCHMARK(aarch64, sadalp, "sadalp", "", nullptr, 4, "int8")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, add, "add", "", nullptr, 4, "int32")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, fadd, "fadd", "", nullptr, 4, "fp32")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, smull, "smull", "", nullptr, 4, "int8")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, smlal, "smlal_4b", "", nullptr, 8, "int8")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, smlal_8b, "smlal_8b", "", nullptr, 16,
+                           "int8")
+//! for 8x8x16
+MEGPEAK_REGISTER_BENCHMARK(aarch64, dupd_lane_s8, "dupd_lane_s8", "", nullptr,
+                           8, "int8")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, mlaq_lane_s16, "mlaq_lane_s16", "", nullptr,
+                           16, "int16")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, sshll, "sshll", "", nullptr, 8, "int8")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, tbl, "tbl", "", nullptr, 16, "shuffle")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ins, "ins", "", nullptr, 2, "shuffle")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, sqrdmulh, "sqrdmulh", "", nullptr, 4,
+                           "int32")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, usubl, "usubl", "", nullptr, 4, "int16")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, abs, "abs", "", nullptr, 4, "int32")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, fcvtzs, "fcvtzs", "", nullptr, 4, "fp32")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, scvtf, "scvtf", "", nullptr, 4, "fp32")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, fcvtns, "fcvtns", "", nullptr, 4, "fp32")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, fcvtms, "fcvtms", "", nullptr, 4, "fp32")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, fcvtps, "fcvtps", "", nullptr, 4, "fp32")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, fcvtas, "fcvtas", "", nullptr, 4, "fp32")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, fcvtn, "fcvtn", "", nullptr, 4, "fp32")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, fcvtl, "fcvtl", "", nullptr, 4, "fp32")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, prefetch_very_long, "prefetch_very_long",
+                           "", nullptr, 4, "load_store,extended")
 
-  //! for 8x8x16
-  benchmark(dupd_lane_s8_throughput, dupd_lane_s8_latency, "dupd_lane_s8", 8);
-  benchmark(mlaq_lane_s16_throughput, mlaq_lane_s16_latency, "mlaq_lane_s16",
-            16);
-  benchmark(sshll_throughput, sshll_latency, "sshll", 8);
-
-  benchmark(tbl_throughput, tbl_latency, "tbl", 16);
-  benchmark(ins_throughput, ins_latency, "ins", 2);
+//! dual issue of the load/store and the computation instructions
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ins_ldd, "ins_ldd", "", nullptr, 2,
+                           "dual_issue,load_store", "Test ldd ins dual issue")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldd_ldx_ins, "ldd_ldx_ins", "", nullptr, 4,
+                           "dual_issue,load_store,extended")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldqstq, "ldqstq", "", nullptr, 4,
+                           "dual_issue,load_store,extended",
+                           "Test ldq stq dual issue")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldq_fmlaq, "ldq_fmlaq", "", nullptr, 8,
+                           "dual_issue,fp32,load_store")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, stq_fmlaq_lane, "stq_fmlaq_lane", "",
+                           nullptr, 8, "dual_issue,fp32,load_store,extended",
+                           "Test stq fmlaq_lane dual issue")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldd_fmlad, "ldd_fmlad", "", nullptr, 4,
+                           "dual_issue,fp32,load_store,extended",
+                           "Test ldd fmlad dual issue")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldq_fmlaq_sep, "ldq_fmlaq_sep", "", nullptr,
+                           8, "dual_issue,fp32,load_store,extended",
+                           "Test throughput ldq + 2 x fmlaq")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldq_fmlaq_lane_sep, "ldq_fmlaq_lane_sep",
+                           "", nullptr, 8,
+                           "dual_issue,fp32,load_store,extended",
+                           "Test compute throughput ldq + 2 x fmlaq_lane")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldd_fmlaq_sep, "ldd_fmlaq_sep", "", nullptr,
+                           8, "dual_issue,fp32,load_store",
+                           "Test compute throughput ldq + fmlaq")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, lds_fmlaq_lane_sep, "lds_fmlaq_lane_sep",
+                           "", nullptr, 8,
+                           "dual_issue,fp32,load_store,extended")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldd_fmlaq_lane_sep, "ldd_fmlaq_lane_sep",
+                           "", nullptr, 8, "dual_issue,fp32,load_store",
+                           "Test compute throughput ldd + fmlaq_lane")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldx_fmlaq_lane_sep, "ldx_fmlaq_lane_sep",
+                           "", nullptr, 8,
+                           "dual_issue,fp32,load_store,extended")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldd_ldx_ins_fmlaq_lane_sep,
+                           "ldd_ldx_ins_fmlaq_lane_sep", "", nullptr, 8,
+                           "dual_issue,fp32,load_store",
+                           "Test compute throughput ldd+fmlaq+ldx+fmlaq+ins+fmlaq")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldd_nop_ldx_ins_fmlaq_lane_sep,
+                           "ldd_nop_ldx_ins_fmlaq_lane_sep", "", nullptr, 8,
+                           "dual_issue,fp32,load_store,extended")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ins_fmlaq_lane_1_4_sep,
+                           "ins_fmlaq_lane_1_4_sep", "", nullptr, 8,
+                           "dual_issue,fp32",
+                           "Test compute throughput ins + 4 x fmlaq_lane")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldd_fmlaq_lane_1_4_sep,
+                           "ldd_fmlaq_lane_1_4_sep", "", nullptr, 8,
+                           "dual_issue,fp32,load_store",
+                           "Test compute throughput ldd + 4 x fmlaq_lane")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldq_fmlaq_lane_1_4_sep,
+                           "ldq_fmlaq_lane_1_4_sep", "", nullptr, 8,
+                           "dual_issue,fp32,load_store,extended",
+                           "Test compute throughput ldq + 4 x fmlaq_lane")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ins_fmlaq_lane_1_3_sep,
+                           "ins_fmlaq_lane_1_3_sep", "", nullptr, 8,
+                           "dual_issue,fp32,extended",
+                           "Test compute throughput ins + 3 x fmlaq_lane")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldd_fmlaq_lane_1_3_sep,
+                           "ldd_fmlaq_lane_1_3_sep", "", nullptr, 8,
+                           "dual_issue,fp32,load_store,extended")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldq_fmlaq_lane_1_3_sep,
+                           "ldq_fmlaq_lane_1_3_sep", "", nullptr, 8,
+                           "dual_issue,fp32,load_store,extended",
+                           "Test compute throughput ldq + 3 x fmlaq_lane")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldq_fmlaq_lane_1_2_sep,
+                           "ldq_fmlaq_lane_1_2_sep", "", nullptr, 8,
+                           "dual_issue,fp32,load_store,extended",
+                           "Test compute throughput ldq + 2 x fmlaq_lane")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ins_fmlaq_lane_sep, "ins_fmlaq_lane_sep",
+                           "", nullptr, 8, "dual_issue,fp32")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, dupd_fmlaq_lane_sep, "dupd_fmlaq_lane_sep",
+                           "", nullptr, 8, "dual_issue,fp32,extended")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, smlal_8b_addp, "smlal_8b_addp", "", nullptr,
+                           16, "dual_issue,int8,extended")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, smlal_8b_dupd, "smlal_8b_dupd", "", nullptr,
+                           16, "dual_issue,int8,extended")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldd_smlalq_sep, "ldd_smlalq_sep_8b", "",
+                           nullptr, 16, "dual_issue,int8,load_store,extended",
+                           "Test ldd smlalq dual issue")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldq_smlalq_sep, "ldq_smlalq_sep", "",
+                           nullptr, 16, "dual_issue,int8,load_store,extended",
+                           "Test ldq smlalq dual issue")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, lddx2_smlalq_sep, "lddx2_smlalq_sep", "",
+                           nullptr, 16, "dual_issue,int8,load_store,extended")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, smlal_sadalp, "smlal_sadalp", "", nullptr,
+                           16, "dual_issue,int8,extended")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, smull_smlal_sadalp, "smull_smlal_sadalp",
+                           "", nullptr, 32, "dual_issue,int8,extended",
+                           "Test smull smlal dual issue")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, smull_smlal_sadalp_sep,
+                           "smull_smlal_sadalp_sep", "", nullptr, 16,
+                           "dual_issue,int8,extended")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ins_smlalq_sep_1_2, "ins_smlalq_sep_1_2",
+                           "", nullptr, 16, "dual_issue,int8,extended")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldx_ins_smlalq_sep, "ldx_ins_smlalq_sep",
+                           "", nullptr, 16,
+                           "dual_issue,int8,load_store,extended")
+#if __ARM_FEATURE_DOTPROD
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldrd_sdot_lane, "ldrd_sdot_lane", "dotprod",
+                           nullptr, 32, "dual_issue,int8,load_store,extended")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldrq_sdot_lane, "ldrq_sdot_lane", "dotprod",
+                           nullptr, 32, "dual_issue,int8,load_store,extended")
+#endif
+MEGPEAK_REGISTER_BENCHMARK(aarch64, dupd_lane_smlal_s8, "dupd_lane_smlal_s8",
+                           "", nullptr, 16, "dual_issue,int8,extended")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldd_mla_s16_lane_1_4_sep,
+                           "ldd_mla_s16_lane_1_4_sep", "", nullptr, 16,
+                           "dual_issue,int16,load_store,extended")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, ldrd_sshll, "ldrd_sshll", "", nullptr, 8,
+                           "dual_issue,int8,load_store,extended")
+MEGPEAK_REGISTER_BENCHMARK(aarch64, sshll_ins_sep, "sshll_ins_sep", "", nullptr,
+                           8, "dual_issue,int8,extended")
 
-  benchmark(sqrdmulh_throughput, sqrdmulh_latency, "sqrdmulh");
-  benchmark(usubl_throughput, usubl_latency, "usubl");
-  benchmark(abs_throughput, abs_latency, "abs");
-  benchmark(fcvtzs_throughput, fcvtzs_latency, "fcvtzs");
-  benchmark(scvtf_throughput, scvtf_latency, "scvtf");
-  benchmark(fcvtns_throughput, fcvtns_latency, "fcvtns");
-  benchmark(fcvtms_throughput, fcvtms_latency, "fcvtms");
-  benchmark(fcvtps_throughput, fcvtps_latency, "fcvtps");
-  benchmark(fcvtas_throughput, fcvtas_latency, "fcvtas");
-  benchmark(fcvtn_throughput, fcvtn_latency, "fcvtn");
-  benchmark(fcvtl_throughput, fcvtl_latency, "fcvtl");
-#if MEGPEAK_WITH_ALL_BENCHMARK
-  benchmark(prefetch_very_long_throughput, prefetch_very_long_latency,
-            "prefetch_very_long");
+MEGPEAK_REGISTER_ILP_SWEEP(aarch64, fmla, "fmla")
+MEGPEAK_REGISTER_ILP_SWEEP(aarch64, mla, "mla")
+MEGPEAK_REGISTER_ILP_SWEEP(aarch64, fadd, "fadd")
+#if __ARM_FEATURE_DOTPROD
+MEGPEAK_REGISTER_ILP_SWEEP(aarch64, sdot, "sdot")
 #endif
 
-  aarch64_dual_issue();
+void megpeak::aarch64() {
+    run_benchmarks(select_benchmarks("aarch64"));
 }
 #else
 void megpeak::aarch64() {}
@@ -72,9 +72,9 @@ THROUGHPUT_MEM_ITER(cb, mlaq_lane_s16, 15)
 LATENCY_MEM(cb, mlaq_lane_s16)
 #undef cb
 
-static int ldpq_throughput() {
+static size_t ldpq_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x0, #0\n"                                                  
@@ -104,7 +104,7 @@ static int ldpq_throughput() {
           "v10", "v11", "v12", "v13", "v14", "v15", "v16", "v17", "v18",    
           "v19", "v20", "v21", "v22", "v23", "v24", "v25", "v26", "v27", "v28",    
           "v29", "v30", "v31", "x0");
-    return megpeak::RUNS * 16;
+    return runs * 16;
 }
 
 #define cb(i) "ldp q0, q1, [%[a_ptr]]\n"
@@ -120,6 +120,7 @@ LATENCY(cb, eor)
 
 #define cb(i) "fmla v" #i ".4s, v" #i ".4s, v" #i ".4s\n"
 THROUGHPUT(cb, fmla)
+ILP_SWEEP(cb, fmla)
 #undef cb
 #define cb(i) "fmla v0.4s, v0.4s, v0.4s\n"
 LATENCY(cb, fmla)
@@ -146,6 +147,7 @@ LATENCY(cb, fmla_x2)
 
 #define cb(i) "fadd v" #i ".4s, v" #i ".4s, v" #i ".4s\n"
 THROUGHPUT(cb, fadd)
+ILP_SWEEP(cb, fadd)
 #undef cb
 #define cb(i) "fadd v0.4s, v0.4s, v0.4s\n"
 LATENCY(cb, fadd)
@@ -310,6 +312,7 @@ LATENCY(cb, sshll)
 
 #define cb(i) "mla v" #i ".4s, v" #i ".4s, v" #i ".4s\n"
 THROUGHPUT(cb, mla)
+ILP_SWEEP(cb, mla)
 #undef cb
 #define cb(i) "mla v0.4s, v0.4s, v0.4s\n"
 LATENCY(cb, mla)
@@ -319,6 +322,7 @@ LATENCY(cb, mla)
 
 #define cb(i) "sdot v" #i ".4s, v" #i ".16b, v" #i ".16b\n"
 THROUGHPUT(cb, sdot)
+ILP_SWEEP(cb, sdot)
 #undef cb
 #define cb(i) "sdot v0.4s, v0.16b, v0.16b\n"
 LATENCY(cb, sdot)
@@ -349,9 +353,9 @@ LATENCY(cb, bfmmla)
 #endif
 
 // clang-format off
-static int prefetch_very_long_throughput() {
+static size_t prefetch_very_long_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x20, #0\n"                                                  
@@ -379,7 +383,7 @@ static int prefetch_very_long_throughput() {
           "v29", "v30", "v31", "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9",
           "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17", "x18", 
           "x19", "x20");
-    return megpeak::RUNS * 16;
+    return runs * 16;
 }
 #define cb(i) "prfm pldl1keep, [%[a_ptr], #1024]\n"
 LATENCY_MEM(cb, prefetch_very_long)
@@ -19,7 +19,7 @@
 #define eor(i) "eor v" #i ".16b, v" #i ".16b, v" #i ".16b\n"
 // clang-format off
 #define THROUGHPUT(cb, func)                                                \
-    static int func##_throughput() {                                        \
+    static size_t func##_throughput(size_t runs) {                          \
         asm volatile(                                                       \
         UNROLL_CALL(20, eor)                                                \
         "mov x0, %x[RUNS]\n"                                                \
@@ -28,32 +28,48 @@
         "subs x0, x0, #1 \n"                                                \
         "bne 1b \n"                                                         \
         :                                                                   \
-        : [RUNS] "r"(megpeak::RUNS)                                         \
+        : [RUNS] "r"(runs)                                                  \
         : "cc", "v0", "v1", "v2", "v3", "v4", "v5", "v6", "v7", "v8", "v9", \
           "v10", "v11", "v12", "v13", "v14", "v15", "v16", "v17", "v18",    \
           "v19", "v20", "v21", "v22", "x0");                                \
-        return megpeak::RUNS * 20;                                          \
+        return runs * 20;                                                   \
     }
 
-#define LATENCY(cb, func)              \
-    static int func##_latency() {      \
-        asm volatile(                  \
-        "eor v0.16b, v0.16b, v0.16b\n" \
-        "mov x0, %x[RUNS]\n"           \
-        "1:\n"                         \
-        UNROLL_CALL(20, cb)            \
-        "subs x0, x0, #1 \n"           \
-        "bne 1b \n"                    \
-        :                              \
-        : [RUNS] "r"(megpeak::RUNS)    \
-        : "cc", "v0", "x0");           \
-        return megpeak::RUNS * 20;     \
+#define LATENCY(cb, func)                       \
+    static size_t func##_latency(size_t runs) { \
+        asm volatile(                           \
+        "eor v0.16b, v0.16b, v0.16b\n"          \
+        "mov x0, %x[RUNS]\n"                    \
+        "1:\n"                                  \
+        UNROLL_CALL(20, cb)                     \
+        "subs x0, x0, #1 \n"                    \
+        "bne 1b \n"                             \
+        :                                       \
+        : [RUNS] "r"(runs)                      \
+        : "cc", "v0", "x0");                    \
+        return runs * 20;                       \
+    }
+
+#define ILP(cb, func, chains)                                               \
+    static size_t func##_chains##chains(size_t runs) {                      \
+        asm volatile(                                                       \
+        UNROLL_CALL(chains, eor)                                            \
+        "mov x0, %x[RUNS]\n"                                                \
+        "1:\n"                                                              \
+        ILP_BODY(chains, cb)                                                \
+        "subs x0, x0, #1 \n"                                                \
+        "bne 1b \n"                                                         \
+        :                                                                   \
+        : [RUNS] "r"(runs)                                                  \
+        : "cc", "v0", "v1", "v2", "v3", "v4", "v5", "v6", "v7", "v8", "v9", \
+          "v10", "v11", "v12", "v13", "v14", "v15", "x0");                  \
+        return runs * chains * ILP_CHAIN_LENGTH;                            \
     }
 
 #define THROUGHPUT_MEM_ITER(cb, func, iter)                                   \
-    static int func##_throughput() {                                          \
+    static size_t func##_throughput(size_t runs) {                            \
         const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());     \
-        size_t run_times = megpeak::RUNS;                                     \
+        size_t run_times = runs;                                              \
         asm volatile(                                                         \
         UNROLL_CALL(iter, eor)                                                \
         "mov x28, %x[RUNS]\n"                                                 \
@@ -68,15 +84,15 @@
           "v19", "v20", "v21", "v22", "x0", "x1", "x2", "x3", "x4", "x5",     \
           "x6", "x7", "x8", "x9", "x10", "x11", "x12", "x13", "x14", "x15",   \
           "x16", "x17", "x18", "x19", "x20", "x28", "memory");                \
-        return megpeak::RUNS * iter;                                          \
+        return runs * iter;                                                   \
     }
 
 #define THROUGHPUT_MEM(cb, func) THROUGHPUT_MEM_ITER(cb, func, 20)
 
 #define LATENCY_MEM(cb, func)                                             \
-    static int func##_latency() {                                         \
+    static size_t func##_latency(size_t runs) {                           \
         const float* a_ptr = reinterpret_cast<float*>(get_mem_align64()); \
-        size_t run_times = megpeak::RUNS;                                 \
+        size_t run_times = runs;                                          \
         asm volatile(                                                     \
             "eor v0.16b, v0.16b, v0.16b\n"                                \
             "mov x28, %x[RUNS]\n"                                         \
@@ -87,7 +103,7 @@
             :                                                             \
             : [a_ptr] "r"(a_ptr), [RUNS] "r"(run_times)                   \
             : "cc", "v0","v1", "x0", "x1", "x28", "memory");              \
-        return megpeak::RUNS * 20;                                        \
+        return runs * 20;                                                 \
     }
 //!!!
 // clang-format off
@@ -97,9 +113,9 @@
  *      以A55为例，其频率为1.8GHz，周期为1/1.8ns,约为0.56ns。
  *      在A55测试的throughput为0.641968 ns，约为1周期，故可推测ins和ldd在A55可以双发射。
  */
-static int ins_ldd_throughput() {
+static size_t ins_ldd_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x28, #0\n"                                                  
@@ -149,7 +165,7 @@ static int ins_ldd_throughput() {
           "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17", "x18", 
           "x19", "x20", "x28", "memory");
     // 16表示将上面的汇编两两一组分为16组，每组包含1条ins和1条ldr，故计算的throughput表示ins+ldr的throughput。
-    return megpeak::RUNS * 16; 
+    return runs * 16; 
 }
 #define cb(i) "ins v0.d[0], x0\n"\
               "ldr d0, [%[a_ptr]]\n"
@@ -202,9 +218,9 @@ LATENCY_MEM(cb, ldq_fmlaq)
  * @brief 测试stq + 3xfmla指令组合的性能
  * 
  */
-static int stq_fmlaq_lane_throughput() {
+static size_t stq_fmlaq_lane_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x0, #0\n"                                                  
@@ -266,9 +282,9 @@ LATENCY_MEM(cb, ldd_fmlad)
  * @brief 测试ldq + 2xfmlaq指令组合的性能
  * 
  */
-static int ldq_fmlaq_sep_throughput() {
+static size_t ldq_fmlaq_sep_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x0, #0\n"                                                  
@@ -306,7 +322,7 @@ static int ldq_fmlaq_sep_throughput() {
           "v10", "v11", "v12", "v13", "v14", "v15", "v16", "v17", "v18",    
           "v19", "v20", "v21", "v22", "v23", "v24", "v25", "v26", "v27", "v28",    
           "v29", "v30", "v31", "x0", "memory");
-    return megpeak::RUNS * 16;
+    return runs * 16;
 }
 #define cb(i) "ldr q0, [%[a_ptr]]\n"\
               "fmla v1.4s, v1.4s, v1.4s\n"
@@ -319,9 +335,9 @@ LATENCY_MEM(cb, ldq_fmlaq_sep)
  * @brief 测试ldq + 2xfmlaq_lane指令组合的性能
  * 
  */
-static int ldq_fmlaq_lane_sep_throughput() {
+static size_t ldq_fmlaq_lane_sep_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x0, #0\n"                                                  
@@ -359,7 +375,7 @@ static int ldq_fmlaq_lane_sep_throughput() {
           "v10", "v11", "v12", "v13", "v14", "v15", "v16", "v17", "v18",    
           "v19", "v20", "v21", "v22", "v23", "v24", "v25", "v26", "v27", "v28",    
           "v29", "v30", "v31", "x0");
-    return megpeak::RUNS * 16;
+    return runs * 16;
 }
 #define cb(i) "ldr q0, [%[a_ptr]]\n"\
               "fmla v1.4s, v1.4s, v1.s [0]\n"
@@ -379,9 +395,9 @@ LATENCY_MEM(cb, ldq_fmlaq_lane_sep)
  *      而ldd+fmlaq的throughput为0.630208 ns，约为一个周期，
  *      表明ldd+fmlaq可以双发射（注意：本测试中ldd和fmla没有寄存器资源的依赖）。
  */
-static int ldd_fmlaq_sep_throughput() {
+static size_t ldd_fmlaq_sep_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x0, #0\n"                                                  
@@ -427,7 +443,7 @@ static int ldd_fmlaq_sep_throughput() {
           "v10", "v11", "v12", "v13", "v14", "v15", "v16", "v17", "v18",    
           "v19", "v20", "v21", "v22", "v23", "v24", "v25", "v26", "v27", "v28",    
           "v29", "v30", "v31", "x0");
-    return megpeak::RUNS * 16;
+    return runs * 16;
 }
 #define cb(i) "ldr d0, [%[a_ptr]]\n"\
               "fmla v1.4s, v1.4s, v1.4s\n"
@@ -580,9 +596,9 @@ LATENCY_MEM(cb, lddx2_smlalq_sep)
  * @brief 测试 smlal + ldx + 3xsmlal + ldd + ins指令组合的性能
  * 
  */
-static int ldx_ins_smlalq_sep_throughput() {
+static size_t ldx_ins_smlalq_sep_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x20, #0\n"                                                  
@@ -630,7 +646,7 @@ static int ldx_ins_smlalq_sep_throughput() {
           "v29", "v30", "v31", "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9",
           "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17", "x18", 
           "x19", "x20");
-    return megpeak::RUNS * 16;
+    return runs * 16;
 }
 #define cb(i) "ldr x0, [%[a_ptr]]\n"\
               "ins v1.d[0], x0\n"\
@@ -644,9 +660,9 @@ LATENCY_MEM(cb, ldx_ins_smlalq_sep)
  * @brief 测试 2xsmlal + ins指令组合的性能
  * 
  */
-static int ins_smlalq_sep_1_2_throughput() {
+static size_t ins_smlalq_sep_1_2_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x20, #0\n"                                                  
@@ -687,7 +703,7 @@ static int ins_smlalq_sep_1_2_throughput() {
           "v29", "v30", "v31", "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9",
           "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17", "x18", 
           "x19", "x20");
-    return megpeak::RUNS * 16;
+    return runs * 16;
 }
 #define cb(i) "ins v1.d[0], x0\n"\
               "smlal v1.8h, v1.8b, v1.8b\n"
@@ -719,9 +735,9 @@ LATENCY_MEM(cb, ldx_fmlaq_lane_sep)
  *      ldd + 4xfmlaq_lane: throughput: 0.638399 ns 12.531342 GFlops
  *      以上结果表明，在A55上，上述指令组合增加计算密度不会有性能提升，即ldd+fmlaq_lane已经可以充分发挥A55的计算能力。
  */
-static int ldd_fmlaq_lane_1_4_sep_throughput() {
+static size_t ldd_fmlaq_lane_1_4_sep_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x20, #0\n"                                                  
@@ -761,7 +777,7 @@ static int ldd_fmlaq_lane_1_4_sep_throughput() {
           "v29", "v30", "v31", "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9",
           "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17", "x18", 
           "x19", "x20", "x22");
-    return megpeak::RUNS * 16;
+    return runs * 16;
 }
 #define cb(i) "ldr x0, [%[a_ptr]]\n"\
               "fmla v1.4s, v1.4s, v1.s [0]\n"
@@ -774,9 +790,9 @@ LATENCY_MEM(cb, ldd_fmlaq_lane_1_4_sep)
  * @brief 测试 ldd + 4xmla_s16_lane 指令组合的性能
  * 
  */
-static int ldd_mla_s16_lane_1_4_sep_throughput() {
+static size_t ldd_mla_s16_lane_1_4_sep_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x20, #0\n"                                                  
@@ -816,7 +832,7 @@ static int ldd_mla_s16_lane_1_4_sep_throughput() {
           "v29", "v30", "v31", "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9",
           "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17", "x18", 
           "x19", "x20", "x22");
-    return megpeak::RUNS * 16;
+    return runs * 16;
 }
 #define cb(i) "ldr d1, [%[a_ptr]]\n"\
               "mla v1.8h, v1.8h, v1.h [0]\n"
@@ -829,9 +845,9 @@ LATENCY_MEM(cb, ldd_mla_s16_lane_1_4_sep)
  * @brief 测试 sshll + ins 指令组合的性能
  * 
  */
-static int sshll_ins_sep_throughput() {
+static size_t sshll_ins_sep_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x20, #0\n"                                                  
@@ -867,7 +883,7 @@ static int sshll_ins_sep_throughput() {
           "v29", "v30", "v31", "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9",
           "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17", "x18", 
           "x19", "x20", "x22");
-    return megpeak::RUNS * 10;
+    return runs * 10;
 }
 #define cb(i) "ins v1.d[0], x0\n"\
               "sshll v1.8h, v1.8b, #0\n"              
@@ -879,9 +895,9 @@ LATENCY_MEM(cb, sshll_ins_sep)
  * @brief 测试 ldq + 4xfmlaq_lane 指令组合的性能
  *
  */
-static int ldq_fmlaq_lane_1_4_sep_throughput() {
+static size_t ldq_fmlaq_lane_1_4_sep_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x20, #0\n"                                                  
@@ -921,7 +937,7 @@ static int ldq_fmlaq_lane_1_4_sep_throughput() {
           "v29", "v30", "v31", "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9",
           "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17", "x18", 
           "x19", "x20", "x22");
-    return megpeak::RUNS * 16;
+    return runs * 16;
 }
 #define cb(i)               \
     "ldr q1, [%[a_ptr]] \n" \
@@ -939,9 +955,9 @@ LATENCY_MEM(cb, ldq_fmlaq_lane_1_4_sep)
  *      ldd + 4xfmlaq_lane: throughput: 0.638135 ns 12.536536 GFlops
  *      以上结果表明，在A55上，上述指令组合增加计算密度不会有性能提升，即ins+fmlaq_lane已经可以充分发挥A55的计算能力。
  */
-static int ins_fmlaq_lane_1_4_sep_throughput() {
+static size_t ins_fmlaq_lane_1_4_sep_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x20, #0\n"                                                  
@@ -981,7 +997,7 @@ static int ins_fmlaq_lane_1_4_sep_throughput() {
           "v29", "v30", "v31", "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9",
           "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17", "x18", 
           "x19", "x20", "x22");
-    return megpeak::RUNS * 16;
+    return runs * 16;
 }
 #define cb(i) "ins v1.d[0], x0\n"\
               "fmla v1.4s, v1.4s, v1.s [0]\n"
@@ -994,9 +1010,9 @@ LATENCY_MEM(cb, ins_fmlaq_lane_1_4_sep)
  * @brief 测试 ldd + ins + fmlaq_lane + ldx + fmlaq_lane + nop + fmlaq_lane + nop 指令组合的性能
  * 
  */
-static int ldd_fmlaq_lane_1_3_sep_throughput() {
+static size_t ldd_fmlaq_lane_1_3_sep_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x20, #0\n"                                                  
@@ -1057,7 +1073,7 @@ static int ldd_fmlaq_lane_1_3_sep_throughput() {
           "v29", "v30", "v31", "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9",
           "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17", "x18", 
           "x19", "x20", "x22");
-    return megpeak::RUNS * 15;
+    return runs * 15;
 }
 #define cb(i) "ldr x0, [%[a_ptr]]\n"\
               "ins v1.d[0], x0\n"\
@@ -1071,9 +1087,9 @@ LATENCY_MEM(cb, ldd_fmlaq_lane_1_3_sep)
  * @brief 测试 ins + 3xfmlaq_lane 指令组合的性能
  * 
  */
-static int ins_fmlaq_lane_1_3_sep_throughput() {
+static size_t ins_fmlaq_lane_1_3_sep_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x20, #0\n"                                                  
@@ -1114,7 +1130,7 @@ static int ins_fmlaq_lane_1_3_sep_throughput() {
           "v29", "v30", "v31", "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9",
           "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17", "x18", 
           "x19", "x20", "x22");
-    return megpeak::RUNS * 15;
+    return runs * 15;
 }
 #define cb(i) "ldr x0, [%[a_ptr]]\n"\
               "ins v1.d[0], x0\n"\
@@ -1127,9 +1143,9 @@ LATENCY_MEM(cb, ins_fmlaq_lane_1_3_sep)
  * @brief 测试 ldq + 3xfmlaq_lane 指令组合的性能
  *
  */
-static int ldq_fmlaq_lane_1_3_sep_throughput() {
+static size_t ldq_fmlaq_lane_1_3_sep_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x20, #0\n"                                                  
@@ -1166,7 +1182,7 @@ static int ldq_fmlaq_lane_1_3_sep_throughput() {
           "v29", "v30", "v31", "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9",
           "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17", "x18", 
           "x19", "x20", "x22");
-    return megpeak::RUNS * 15;
+    return runs * 15;
 }
 #define cb(i)               \
     "ldr q1, [%[a_ptr]] \n" \
@@ -1178,9 +1194,9 @@ LATENCY_MEM(cb, ldq_fmlaq_lane_1_3_sep)
  * @brief 测试 ldq + 2xfmlaq_lane 指令组合的性能
  *
  */
-static int ldq_fmlaq_lane_1_2_sep_throughput() {
+static size_t ldq_fmlaq_lane_1_2_sep_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x20, #0\n"                                                  
@@ -1221,7 +1237,7 @@ static int ldq_fmlaq_lane_1_2_sep_throughput() {
           "v29", "v30", "v31", "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9",
           "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17", "x18", 
           "x19", "x20", "x22");
-    return megpeak::RUNS * 16;
+    return runs * 16;
 }
 #define cb(i)               \
     "ldr q1, [%[a_ptr]] \n" \
@@ -1236,9 +1252,9 @@ LATENCY_MEM(cb, ldq_fmlaq_lane_1_2_sep)
  *      以A55为例，其频率为1.8GHz，周期为1/1.8ns,约为0.56ns。
  *      ldd+fmla + ldx+fmla + ins+fmla的throughput为0.803760 ns，表明fmla和上面三条指令的组合可以双发射。
  */
-static int ldd_ldx_ins_fmlaq_lane_sep_throughput() {
+static size_t ldd_ldx_ins_fmlaq_lane_sep_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x0, #0\n"                                                  
@@ -1286,7 +1302,7 @@ static int ldd_ldx_ins_fmlaq_lane_sep_throughput() {
           "v29", "v30", "v31", "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9",\
           "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17", "x18", \
           "x19", "x20");
-    return megpeak::RUNS * 16;
+    return runs * 16;
 }
 #define cb(i) "ldr d0, [%[a_ptr]]\n"\
               "fmla v1.4s, v1.4s, v1.s [0]\n"
@@ -1299,9 +1315,9 @@ LATENCY_MEM(cb, ldd_ldx_ins_fmlaq_lane_sep)
  * @brief 测试 ldd + 2xfmlaq_lane + ldx + fmlaq_lane + ins + fmlaq_lane 指令组合的性能
  * 
  */
-static int ldd_nop_ldx_ins_fmlaq_lane_sep_throughput() {
+static size_t ldd_nop_ldx_ins_fmlaq_lane_sep_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x0, #0\n"                                                  
@@ -1350,7 +1366,7 @@ static int ldd_nop_ldx_ins_fmlaq_lane_sep_throughput() {
           "v29", "v30", "v31", "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9",\
           "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17", "x18", \
           "x19", "x20", "memory");
-    return megpeak::RUNS * 16;
+    return runs * 16;
 }
 #define cb(i) "ldr d0, [%[a_ptr]]\n"\
               "fmla v1.4s, v1.4s, v1.s [0]\n"
@@ -1431,9 +1447,9 @@ LATENCY(cb, smull_smlal_sadalp)
  * @brief 测试 smull + smlal + sadalp 指令组合的性能，指令间没有寄存器资源的依赖
  *
  */
-static int smull_smlal_sadalp_sep_throughput() {
+static size_t smull_smlal_sadalp_sep_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
-    size_t run_times = megpeak::RUNS;
+    size_t run_times = runs;
     asm volatile(                                                   
         UNROLL_CALL(20, eor)                                            
         "mov x0, #0\n"                                                  
@@ -1471,7 +1487,7 @@ static int smull_smlal_sadalp_sep_throughput() {
           "v10", "v11", "v12", "v13", "v14", "v15", "v16", "v17", "v18",    
           "v19", "v20", "v21", "v22", "v23", "v24", "v25", "v26", "v27", "v28",    
           "v29", "v30", "v31", "x0");
-    return megpeak::RUNS * 12;
+    return runs * 12;
 }
 #define cb(i)                     \
     "smull v0.8h, v0.8b, v0.8b\n" \
@@ -1529,112 +1545,4 @@ LATENCY_MEM(cb, ldrq_sdot_lane)
 
 #endif
 
-static void aarch64_dual_issue() {
-    using namespace megpeak;
-    benchmark(ins_ldd_throughput, ins_ldd_latency, "ins_ldd", 2,
-              "Test ldd ins dual issue");
-#if MEGPEAK_WITH_ALL_BENCHMARK
-    benchmark(ldd_ldx_ins_throughput, ldd_ldx_ins_latency, "ldd_ldx_ins", 4);
-    benchmark(ldqstq_throughput, ldqstq_latency, "ldqstq", 4,
-              "Test ldq stq dual issue");
-#endif
-    benchmark(ldq_fmlaq_throughput, ldq_fmlaq_latency, "ldq_fmlaq", 8);
-#if MEGPEAK_WITH_ALL_BENCHMARK
-    benchmark(stq_fmlaq_lane_throughput, stq_fmlaq_lane_latency,
-              "stq_fmlaq_lane", 8, "Test stq fmlaq_lane dual issue");
-
-    benchmark(ldd_fmlad_throughput, ldd_fmlad_latency, "ldd_fmlad", 4,
-              "Test ldd fmlad dual issue");
-    benchmark(ldq_fmlaq_sep_throughput, ldq_fmlaq_sep_latency, "ldq_fmlaq_sep",
-              8, "Test throughput ldq + 2 x fmlaq");
-    benchmark(ldq_fmlaq_lane_sep_throughput, ldq_fmlaq_lane_sep_latency,
-              "ldq_fmlaq_lane_sep", 8,
-              "Test compute throughput ldq + 2 x fmlaq_lane");
-#endif
-    benchmark(ldd_fmlaq_sep_throughput, ldd_fmlaq_sep_latency, "ldd_fmlaq_sep",
-              8, "Test compute throughput ldq + fmlaq");
-#if MEGPEAK_WITH_ALL_BENCHMARK
-    benchmark(lds_fmlaq_lane_sep_throughput, lds_fmlaq_lane_sep_latency,
-              "lds_fmlaq_lane_sep", 8);
-#endif
-    benchmark(ldd_fmlaq_lane_sep_throughput, ldd_fmlaq_lane_sep_latency,
-              "ldd_fmlaq_lane_sep", 8,
-              "Test compute throughput ldd + fmlaq_lane");
-#if MEGPEAK_WITH_ALL_BENCHMARK
-    benchmark(ldx_fmlaq_lane_sep_throughput, ldx_fmlaq_lane_sep_latency,
-              "ldx_fmlaq_lane_sep", 8);
-#endif
-    benchmark(ldd_ldx_ins_fmlaq_lane_sep_throughput,
-              ldd_ldx_ins_fmlaq_lane_sep_latency, "ldd_ldx_ins_fmlaq_lane_sep",
-              8, "Test compute throughput ldd+fmlaq+ldx+fmlaq+ins+fmlaq");
-#if MEGPEAK_WITH_ALL_BENCHMARK
-    benchmark(ldd_nop_ldx_ins_fmlaq_lane_sep_throughput,
-              ldd_nop_ldx_ins_fmlaq_lane_sep_latency,
-              "ldd_nop_ldx_ins_fmlaq_lane_sep", 8);
-#endif
-    benchmark(ins_fmlaq_lane_1_4_sep_throughput, ins_fmlaq_lane_1_4_sep_latency,
-              "ins_fmlaq_lane_1_4_sep", 8,
-              "Test compute throughput ins + 4 x fmlaq_lane");
-    benchmark(ldd_fmlaq_lane_1_4_sep_throughput, ldd_fmlaq_lane_1_4_sep_latency,
-              "ldd_fmlaq_lane_1_4_sep", 8,
-              "Test compute throughput ldd + 4 x fmlaq_lane");
-#if MEGPEAK_WITH_ALL_BENCHMARK
-    benchmark(ldq_fmlaq_lane_1_4_sep_throughput, ldq_fmlaq_lane_1_4_sep_latency,
-              "ldq_fmlaq_lane_1_4_sep", 8,
-              "Test compute throughput ldq + 4 x fmlaq_lane");
-    benchmark(ins_fmlaq_lane_1_3_sep_throughput, ins_fmlaq_lane_1_3_sep_latency,
-              "ins_fmlaq_lane_1_3_sep", 8,
-              "Test compute throughput ins + 3 x fmlaq_lane");
-    benchmark(ldd_fmlaq_lane_1_3_sep_throughput, ldd_fmlaq_lane_1_3_sep_latency,
-              "ldd_fmlaq_lane_1_3_sep", 8);
-    benchmark(ldq_fmlaq_lane_1_3_sep_throughput, ldq_fmlaq_lane_1_3_sep_latency,
-              "ldq_fmlaq_lane_1_3_sep", 8,
-              "Test compute throughput ldq + 3 x fmlaq_lane");
-    benchmark(ldq_fmlaq_lane_1_2_sep_throughput, ldq_fmlaq_lane_1_2_sep_latency,
-              "ldq_fmlaq_lane_1_2_sep", 8,
-              "Test compute throughput ldq + 2 x fmlaq_lane");
-#endif
-    benchmark(ins_fmlaq_lane_sep_throughput, ins_fmlaq_lane_sep_latency,
-              "ins_fmlaq_lane_sep", 8);
-#if MEGPEAK_WITH_ALL_BENCHMARK
-    benchmark(dupd_fmlaq_lane_sep_throughput, dupd_fmlaq_lane_sep_latency,
-              "dupd_fmlaq_lane_sep", 8);
-    benchmark(smlal_8b_addp_throughput, smlal_8b_addp_latency, "smlal_8b_addp",
-              16);
-    benchmark(smlal_8b_dupd_throughput, smlal_8b_dupd_latency, "smlal_8b_dupd",
-              16);
-    benchmark(ldd_smlalq_sep_throughput, ldd_smlalq_sep_latency,
-              "ldd_smlalq_sep_8b", 16, "Test ldd smlalq dual issue");
-    benchmark(ldq_smlalq_sep_throughput, ldq_smlalq_sep_latency,
-              "ldq_smlalq_sep", 16, "Test ldq smlalq dual issue");
-    benchmark(lddx2_smlalq_sep_throughput, lddx2_smlalq_sep_latency,
-              "lddx2_smlalq_sep", 16);
-    benchmark(smlal_sadalp_throughput, smlal_sadalp_latency, "smlal_sadalp",
-              16);
-    benchmark(smull_smlal_sadalp_throughput, smull_smlal_sadalp_latency,
-              "smull_smlal_sadalp", 32, "Test smull smlal dual issue");
-    benchmark(smull_smlal_sadalp_sep_throughput, smull_smlal_sadalp_sep_latency,
-              "smull_smlal_sadalp_sep", 16);
-    benchmark(ins_smlalq_sep_1_2_throughput, ins_smlalq_sep_1_2_latency,
-              "ins_smlalq_sep_1_2", 16);
-    benchmark(ldx_ins_smlalq_sep_throughput, ldx_ins_smlalq_sep_latency,
-              "ldx_ins_smlalq_sep", 16);
-
-#if __ARM_FEATURE_DOTPROD
-    benchmark(ldrd_sdot_lane_throughput, ldrd_sdot_lane_latency,
-              "ldrd_sdot_lane", 32);
-    benchmark(ldrq_sdot_lane_throughput, ldrq_sdot_lane_latency,
-              "ldrq_sdot_lane", 32);
-#endif
-    benchmark(dupd_lane_smlal_s8_throughput, dupd_lane_smlal_s8_latency,
-              "dupd_lane_smlal_s8", 16);
-
-    benchmark(ldd_mla_s16_lane_1_4_sep_throughput,
-              ldd_mla_s16_lane_1_4_sep_latency, "ldd_mla_s16_lane_1_4_sep", 16);
-
-    benchmark(ldrd_sshll_throughput, ldrd_sshll_latency, "ldrd_sshll", 8);
-    benchmark(sshll_ins_sep_throughput, sshll_ins_sep_latency, "sshll_ins_sep",
-              8);
-#endif
-}
 #endif
@@ -0,0 +1,522 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/cpu/jit.h"
+
+#if MEGPEAK_JIT && MEGPEAK_AARCH64
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#if defined(__linux__) || defined(__ANDROID__)
+#include <sys/auxv.h>
+#endif
+
+#include "src/backend.h"
+#include "src/cpu/common.h"
+
+using namespace megpeak;
+
+namespace {
+/**
+ * how the arrangement of the vector operands is encoded, all the vector
+ * instructions share the layout of AARCH64_BINARY_INST:
+ * code[31:21] Rm[20:16] flag[15:10] Rn[9:5] Rd[4:0], Q is bit 30 and size
+ * bits 23:22
+ */
+enum class Size {
+    //! only Q, like the bitwise instructions
+    NONE,
+    //! size of the elements
+    INT,
+    //! sz is bit 22, 1 for double
+    FLOAT,
+    //! size of the elements of the sources, half of the destination, Q is
+    //! fixed by the mnemonic(smlal/smlal2)
+    LONG,
+    //! like LONG, but Q is the one of the destination(sadalp)
+    PAIRWISE,
+    //! immh of the shift, Q fixed by the mnemonic(sshll/sshll2)
+    SHLL,
+    //! imm5 of the element in Rm(dup)
+    DUP,
+    //! Q is fixed, only the given arrangement is valid(smmla)
+    FIXED,
+};
+
+//! registers read and written by an instruction
+enum class Form {
+    //! op vd, vd, v15
+    V3,
+    //! op vd, vd, v15.t[0]
+    V_LANE,
+    //! op vd, vd
+    V2,
+    //! dup vd, v15.t[0]
+    V_DUP,
+    //! ins vd.d[0], x17
+    V_INS,
+    //! ldr/str t, [x1, #offset]
+    MEM,
+    //! ldp/stp q, q, [x1, #offset]
+    MEM_PAIR,
+    //! ld1/st1 {vt.t}, [x1]
+    MEM_LD1,
+    //! op xd, xd, x17
+    X3,
+    NOP,
+};
+
+struct A64Inst {
+    const char* name;
+    //! "" for the vector register form, "lane", "x", or the register of the
+    //! memory instructions: "q", "d", "s", "x"
+    const char* variant;
+    //! code and flag of the layout of AARCH64_BINARY_INST, or the whole
+    //! instruction with the registers and offset 0 in code for MEM*
+    const char* code;
+    const char* flag;
+    //! the fixed value of the Rm field, like the opcode bits of V2
+    uint32_t rm;
+    Form form;
+    Size size;
+    //! valid arrangements, bit i is ARRANGEMENTS[i]
+    uint32_t arrangements;
+    //! operations done per element of the destination
+    size_t ops;
+    //! hwcap feature required, "" for the baseline isa
+    const char* isa;
+};
+
+struct Arrangement {
+    const char* name;
+    uint32_t q;
+    uint32_t size;
+    size_t lanes;
+};
+
+const Arrangement ARRANGEMENTS[] = {
+        {"8b", 0, 0, 8}, {"16b", 1, 0, 16}, {"4h", 0, 1, 4}, {"8h", 1, 1, 8},
+        {"2s", 0, 2, 2}, {"4s", 1, 2, 4},   {"2d", 1, 3, 2},
+};
+constexpr size_t NR_ARRANGEMENTS =
+        sizeof(ARRANGEMENTS) / sizeof(ARRANGEMENTS[0]);
+
+constexpr uint32_t B8 = 1 << 0, B16 = 1 << 1, H4 = 1 << 2, H8 = 1 << 3,
+                   S2 = 1 << 4, S4 = 1 << 5, D2 = 1 << 6;
+constexpr uint32_t ALL = B8 | B16 | H4 | H8 | S2 | S4 | D2;
+constexpr uint32_t NO_D = ALL & ~D2, HS = H4 | H8 | S2 | S4,
+                   FP = S2 | S4 | D2, WIDE = H8 | S4 | D2, DOT = S2 | S4;
+
+// clang-format off
+const A64Inst A64_INSTS[] = {
+        {"add", "", "01001110001", "100001", 0, Form::V3, Size::INT, ALL, 1, ""},
+        {"sub", "", "01101110001", "100001", 0, Form::V3, Size::INT, ALL, 1, ""},
+        {"mul", "", "01001110001", "100111", 0, Form::V3, Size::INT, NO_D, 1, ""},
+        {"mla", "", "01001110001", "100101", 0, Form::V3, Size::INT, NO_D, 2, ""},
+        {"addp", "", "01001110001", "101111", 0, Form::V3, Size::INT, ALL, 1, ""},
+        {"sqrdmulh", "", "01101110001", "101101", 0, Form::V3, Size::INT, HS, 1, ""},
+        {"eor", "", "01101110001", "000111", 0, Form::V3, Size::NONE, B8 | B16, 1, ""},
+        {"and", "", "01001110001", "000111", 0, Form::V3, Size::NONE, B8 | B16, 1, ""},
+        {"orr", "", "01001110101", "000111", 0, Form::V3, Size::NONE, B8 | B16, 1, ""},
+        {"fmla", "", "01001110001", "110011", 0, Form::V3, Size::FLOAT, FP, 2, ""},
+        {"fadd", "", "01001110001", "110101", 0, Form::V3, Size::FLOAT, FP, 1, ""},
+        {"fmul", "", "01101110001", "110111", 0, Form::V3, Size::FLOAT, FP, 1, ""},
+        {"fmax", "", "01001110001", "111101", 0, Form::V3, Size::FLOAT, FP, 1, ""},
+        {"fmin", "", "01001110101", "111101", 0, Form::V3, Size::FLOAT, FP, 1, ""},
+        {"smlal", "", "00001110001", "100000", 0, Form::V3, Size::LONG, WIDE, 2, ""},
+        {"smlal2", "", "01001110001", "100000", 0, Form::V3, Size::LONG, WIDE, 2, ""},
+        {"umlal", "", "00101110001", "100000", 0, Form::V3, Size::LONG, WIDE, 2, ""},
+        {"smull", "", "00001110001", "110000", 0, Form::V3, Size::LONG, WIDE, 1, ""},
+        {"smull2", "", "01001110001", "110000", 0, Form::V3, Size::LONG, WIDE, 1, ""},
+        {"umull", "", "00101110001", "110000", 0, Form::V3, Size::LONG, WIDE, 1, ""},
+        {"sdot", "", sdot_code, sdot_flag, 0, Form::V3, Size::NONE, DOT, 8, "dotprod"},
+        {"udot", "", "01101110100", "100101", 0, Form::V3, Size::NONE, DOT, 8, "dotprod"},
+        {"smmla", "", smmla_code, smmla_flag, 0, Form::V3, Size::FIXED, S4, 16, "i8mm"},
+        {"bfmmla", "", bfmmla_code, bfmmla_flag, 0, Form::V3, Size::FIXED, S4, 8, "bf16"},
+        {"fmla", "lane", "01001111100", "000100", 0, Form::V_LANE, Size::FLOAT, FP, 2, ""},
+        {"fmul", "lane", "01001111100", "100100", 0, Form::V_LANE, Size::FLOAT, FP, 1, ""},
+        {"mla", "lane", "01101111000", "000000", 0, Form::V_LANE, Size::INT, HS, 2, ""},
+        {"mul", "lane", "01001111000", "100000", 0, Form::V_LANE, Size::INT, HS, 1, ""},
+        {"sdot", "lane", "01001111100", "111000", 0, Form::V_LANE, Size::NONE, DOT, 8, "dotprod"},
+        {"smlal", "lane", "00001111000", "001000", 0, Form::V_LANE, Size::LONG, S4 | D2, 2, ""},
+        {"smlal2", "lane", "01001111000", "001000", 0, Form::V_LANE, Size::LONG, S4 | D2, 2, ""},
+        {"abs", "", "01001110001", "101110", 0, Form::V2, Size::INT, ALL, 1, ""},
+        {"fcvtzs", "", "01001110101", "101110", 1, Form::V2, Size::FLOAT, FP, 1, ""},
+        {"fcvtns", "", "01001110001", "101010", 1, Form::V2, Size::FLOAT, FP, 1, ""},
+        {"scvtf", "", "01001110001", "110110", 1, Form::V2, Size::FLOAT, FP, 1, ""},
+        {"sadalp", "", "01001110001", "011010", 0, Form::V2, Size::PAIRWISE, H4 | H8 | S2 | S4 | D2, 1, ""},
+        {"uadalp", "", "01101110001", "011010", 0, Form::V2, Size::PAIRWISE, H4 | H8 | S2 | S4 | D2, 1, ""},
+        {"sshll", "", "00001111000", "101001", 0, Form::V2, Size::SHLL, WIDE, 1, ""},
+        {"sshll2", "", "01001111000", "101001", 0, Form::V2, Size::SHLL, WIDE, 1, ""},
+        {"dup", "", "01001110000", "000001", 0, Form::V_DUP, Size::DUP, ALL, 0, ""},
+        {"ins", "x", "01001110000", "000111", 8, Form::V_INS, Size::NONE, D2, 0, ""},
+        {"ldr", "q", "00111101110", "000000", 0, Form::MEM, Size::NONE, 0, 0, ""},
+        {"str", "q", "00111101100", "000000", 0, Form::MEM, Size::NONE, 0, 0, ""},
+        {"ldr", "d", "11111101010", "000000", 0, Form::MEM, Size::NONE, 0, 0, ""},
+        {"str", "d", "11111101000", "000000", 0, Form::MEM, Size::NONE, 0, 0, ""},
+        {"ldr", "s", "10111101010", "000000", 0, Form::MEM, Size::NONE, 0, 0, ""},
+        {"str", "s", "10111101000", "000000", 0, Form::MEM, Size::NONE, 0, 0, ""},
+        {"ldr", "x", "11111001010", "000000", 0, Form::MEM, Size::NONE, 0, 0, ""},
+        {"str", "x", "11111001000", "000000", 0, Form::MEM, Size::NONE, 0, 0, ""},
+        {"ldp", "q", "10101101010", "000000", 0, Form::MEM_PAIR, Size::NONE, 0, 0, ""},
+        {"stp", "q", "10101101000", "000000", 0, Form::MEM_PAIR, Size::NONE, 0, 0, ""},
+        {"ld1", "", "00001100010", "011100", 0, Form::MEM_LD1, Size::INT, ALL, 0, ""},
+        {"st1", "", "00001100000", "011100", 0, Form::MEM_LD1, Size::INT, ALL, 0, ""},
+        {"add", "x", "10001011000", "000000", 0, Form::X3, Size::NONE, 0, 1, ""},
+        {"sub", "x", "11001011000", "000000", 0, Form::X3, Size::NONE, 0, 1, ""},
+        {"and", "x", "10001010000", "000000", 0, Form::X3, Size::NONE, 0, 1, ""},
+        {"orr", "x", "10101010000", "000000", 0, Form::X3, Size::NONE, 0, 1, ""},
+        {"eor", "x", "11001010000", "000000", 0, Form::X3, Size::NONE, 0, 1, ""},
+        {"mul", "x", "10011011000", "011111", 0, Form::X3, Size::NONE, 0, 1, ""},
+        {"nop", "", "11010101000", "001000", 3, Form::NOP, Size::NONE, 0, 0, ""},
+};
+// clang-format on
+
+//! v15 is the element/dup source, so that the lane forms of .h, which only
+//! encode v0-v15, do not depend on any chain. It stays zero and is also the
+//! second source of V3, op vd, vd, vd would be a zeroing idiom for eor and
+//! sub and a move for orr
+constexpr uint32_t LANE_REG = 15;
+//! x0 is the loop counter and x1 the memory, x17 is the source of ins and
+//! the zero second source of X3 like v15, x18 is the platform register
+constexpr uint32_t INS_REG = 17;
+constexpr uint32_t MEM_REG = 1;
+constexpr uint32_t XZR = 31, SP = 31;
+//! the mix is repeated until a loop iteration has at least this many
+//! instructions, so the loop tail is negligible and all the registers are used
+constexpr size_t MIN_LOOP_INSTS = 32;
+//! stride of the memory operands, ldp q encodes offsets up to 1008
+constexpr size_t MEM_STRIDE = 64;
+constexpr size_t NR_MEM_SLOTS = 1024 / MEM_STRIDE;
+//! registers of a class the write-only loads rotate over in the throughput
+//! loop, see emit_loop()
+constexpr size_t NR_LOAD_REGS = 4;
+
+std::vector<uint32_t> get_vec_regs() {
+    std::vector<uint32_t> ret;
+    for (uint32_t reg = 0; reg < 32; reg++) {
+        if (reg != LANE_REG) {
+            ret.push_back(reg);
+        }
+    }
+    return ret;
+}
+
+std::vector<uint32_t> get_gpr_regs() {
+    std::vector<uint32_t> ret;
+    for (uint32_t reg = 2; reg < INS_REG; reg++) {
+        ret.push_back(reg);
+    }
+    return ret;
+}
+
+uint32_t bits(const char* str) {
+    return strtoul(str, nullptr, 2);
+}
+
+//! same layout as AARCH64_BINARY_INST
+uint32_t binary_inst(uint32_t code, uint32_t rm, uint32_t flag, uint32_t rn,
+                     uint32_t rd) {
+    return code << 21 | (rm & 0x1f) << 16 | (flag & 0x3f) << 10 |
+           (rn & 0x1f) << 5 | (rd & 0x1f);
+}
+
+bool has_feature(const std::string& isa) {
+    if (isa.empty()) {
+        return true;
+    }
+#if defined(__linux__) || defined(__ANDROID__)
+    unsigned long hwcap = getauxval(AT_HWCAP);
+#ifdef AT_HWCAP2
+    unsigned long hwcap2 = getauxval(AT_HWCAP2);
+#else
+    unsigned long hwcap2 = 0;
+#endif
+    if (isa == "dotprod") {
+        return hwcap & (1 << 20);
+    } else if (isa == "i8mm") {
+        return hwcap2 & (1 << 13);
+    } else if (isa == "bf16") {
+        return hwcap2 & (1 << 14);
+    }
+    return false;
+#else
+    return true;
+#endif
+}
+
+//! an instruction of the mix with its resolved encoding
+struct Op {
+    const A64Inst* inst = nullptr;
+    //! the instruction with the arrangement, without the registers
+    uint32_t base = 0;
+    size_t lanes = 1;
+};
+
+bool is_write_only(const Op& op) {
+    auto form = op.inst->form;
+    return form == Form::V_DUP || form == Form::MEM_PAIR ||
+           ((form == Form::MEM || form == Form::MEM_LD1) &&
+            op.inst->name[0] == 'l');
+}
+
+bool is_vector(const Op& op) {
+    auto form = op.inst->form;
+    if (form == Form::V_INS) {
+        return true;
+    }
+    return form != Form::X3 && strcmp(op.inst->variant, "x") != 0;
+}
+
+Op resolve(const MixInst& mix) {
+    const Arrangement* arrangement = nullptr;
+    std::string variant;
+    for (auto&& operand : mix.operands) {
+        bool found = false;
+        for (auto&& arr : ARRANGEMENTS) {
+            if (operand == arr.name) {
+                arrangement = &arr;
+                found = true;
+            }
+        }
+        if (!found) {
+            megpeak_assert(variant.empty(), "too many operands in \"%s\"",
+                           mix.text.c_str());
+            variant = operand;
+        }
+    }
+    Op op;
+    for (auto&& inst : A64_INSTS) {
+        if (mix.mnemonic == inst.name && variant == inst.variant) {
+            op.inst = &inst;
+        }
+    }
+    megpeak_assert(op.inst,
+                   "unknown instruction \"%s\" in the mix, the operands are "
+                   "an arrangement(8b/16b/4h/8h/2s/4s/2d), lane for the by "
+                   "element forms, x for the general purpose registers and "
+                   "q/d/s/x for ldr/str/ldp/stp",
+                   mix.text.c_str());
+    auto&& inst = *op.inst;
+    megpeak_assert(has_feature(inst.isa),
+                   "\"%s\" requires %s, which is not supported",
+                   mix.text.c_str(), inst.isa);
+    op.base = binary_inst(bits(inst.code), inst.rm, bits(inst.flag), 0, 0);
+    if (!inst.arrangements) {
+        megpeak_assert(!arrangement, "\"%s\" has no arrangement",
+                       mix.text.c_str());
+        return op;
+    }
+    if (!arrangement) {
+        //! the default is the widest valid one of 4s, 8h, 2d, 16b
+        for (auto&& name : {"4s", "8h", "2d", "16b"}) {
+            for (size_t i = 0; i < NR_ARRANGEMENTS; i++) {
+                if (!arrangement && (inst.arrangements & (1 << i)) &&
+                    !strcmp(ARRANGEMENTS[i].name, name)) {
+                    arrangement = &ARRANGEMENTS[i];
+                }
+            }
+        }
+    }
+    size_t index = arrangement - ARRANGEMENTS;
+    megpeak_assert(arrangement && (inst.arrangements & (1 << index)),
+                   "invalid arrangement of \"%s\"", mix.text.c_str());
+    op.lanes = arrangement->lanes;
+    uint32_t q = arrangement->q << 30, size = arrangement->size;
+    switch (inst.size) {
+        case Size::NONE:
+            op.base = (op.base & ~(1u << 30)) | q;
+            break;
+        case Size::INT:
+            //! ld1/st1 encode the size in bits 11:10, bit 22 is the load
+            op.base = (op.base & ~(1u << 30)) | q |
+                      (inst.form == Form::MEM_LD1 ? size << 10 : size << 22);
+            break;
+        case Size::FLOAT:
+            op.base = (op.base & ~(1u << 30)) | q | (size == 3) << 22;
+            break;
+        case Size::LONG:
+            op.base |= (size - 1) << 22;
+            break;
+        case Size::PAIRWISE:
+            op.base = (op.base & ~(1u << 30)) | q | (size - 1) << 22;
+            break;
+        case Size::SHLL:
+            op.base |= 1u << (19 + size - 1);
+            break;
+        case Size::DUP:
+            op.base = (op.base & ~(1u << 30)) | q | (1u << size) << 16;
+            break;
+        case Size::FIXED:
+            break;
+    }
+    return op;
+}
+
+uint32_t encode(const Op& op, uint32_t reg, uint32_t reg2, uint32_t offset) {
+    auto&& inst = *op.inst;
+    switch (inst.form) {
+        case Form::V3:
+        case Form::V_LANE:
+            return op.base | binary_inst(0, LANE_REG, 0, reg, reg);
+        case Form::X3:
+            return op.base | binary_inst(0, INS_REG, 0, reg, reg);
+        case Form::V2:
+            return op.base | binary_inst(0, 0, 0, reg, reg);
+        case Form::V_DUP:
+            return op.base | binary_inst(0, 0, 0, LANE_REG, reg);
+        case Form::V_INS:
+            return op.base | binary_inst(0, 0, 0, INS_REG, reg);
+        case Form::MEM: {
+            //! imm12 is scaled by the size of the register
+            uint32_t scale = inst.variant[0] == 'q'
+                                     ? 16
+                                     : inst.variant[0] == 's' ? 4 : 8;
+            return op.base | (offset / scale) << 10 | MEM_REG << 5 | reg;
+        }
+        case Form::MEM_PAIR:
+            return op.base | (offset / 16) << 15 | reg2 << 10 |
+                   MEM_REG << 5 | reg;
+        case Form::MEM_LD1:
+            return op.base | MEM_REG << 5 | reg;
+        case Form::NOP:
+            return op.base | 0x1f;
+    }
+    return 0;
+}
+
+class Emitter {
+public:
+    std::vector<uint8_t>& code() { return m_code; }
+    size_t size() const { return m_code.size() / 4; }
+
+    void inst(uint32_t value) {
+        for (size_t i = 0; i < 4; i++) {
+            m_code.push_back(value >> (i * 8));
+        }
+    }
+
+    //! stp/ldp d, d, [sp, #offset], pre-index for stp and post-index for
+    //! ldp when index is set
+    void pair_d(bool load, bool index, uint32_t reg, int offset) {
+        uint32_t base = load ? (index ? 0x6cc00000 : 0x6d400000)
+                             : (index ? 0x6d800000 : 0x6d000000);
+        inst(base | ((offset / 8) & 0x7f) << 15 | (reg + 1) << 10 | SP << 5 |
+             reg);
+    }
+
+private:
+    std::vector<uint8_t> m_code;
+};
+
+/**
+ * void (size_t runs in x0, void* mem in x1), with latency all the vector
+ * instructions use v0 and the gpr ones x2, otherwise the registers are
+ * allocated round robin. The low halves of v8-v15 are callee saved.
+ */
+std::vector<uint8_t> emit_loop(const std::vector<Op>& ops, size_t nr_passes,
+                               bool latency) {
+    Emitter e;
+    e.pair_d(false, true, 8, -64);
+    e.pair_d(false, false, 10, 16);
+    e.pair_d(false, false, 12, 32);
+    e.pair_d(false, false, 14, 48);
+    //! zero all the registers, so that no instruction runs on denormals
+    for (uint32_t reg = 0; reg < 32; reg++) {
+        //! eor v.16b, v.16b, v.16b
+        e.inst(binary_inst(bits("01101110001"), reg, bits("000111"), reg,
+                           reg));
+    }
+    for (uint32_t reg = 2; reg <= INS_REG; reg++) {
+        //! movz x, #0
+        e.inst(0xd2800000 | reg);
+    }
+    while (e.size() % 16) {
+        e.inst(0xd503201f);
+    }
+
+    //! when the mix has other instructions, the write-only loads rotate over
+    //! the last registers of a class, otherwise the instructions reading
+    //! the register after a load would wait for the load latency
+    bool has_loads = std::any_of(ops.begin(), ops.end(), is_write_only);
+    bool has_others = !std::all_of(ops.begin(), ops.end(), is_write_only);
+    size_t nr_load_regs = has_loads && has_others ? NR_LOAD_REGS : 0;
+    //! number of registers allocated of a class, of others and of loads
+    size_t nr_vec[2] = {0, 0}, nr_gpr[2] = {0, 0}, nr_mem = 0;
+    auto next_reg = [&](size_t* counters, size_t nr_regs, bool load) {
+        return load ? nr_regs - nr_load_regs + counters[1]++ % nr_load_regs
+                    : counters[0]++ % (nr_regs - nr_load_regs);
+    };
+
+    auto vec_regs = get_vec_regs(), gpr_regs = get_gpr_regs();
+    size_t loop = e.size();
+    for (size_t i = 0; i < nr_passes; i++) {
+        for (auto&& op : ops) {
+            //! loads which only write the register would cut the chain,
+            //! they write the next registers instead
+            size_t latency_reg = is_write_only(op) ? 1 : 0;
+            auto&& regs = is_vector(op) ? vec_regs : gpr_regs;
+            auto counters = is_vector(op) ? nr_vec : nr_gpr;
+            bool load = nr_load_regs && is_write_only(op);
+            uint32_t reg, reg2;
+            if (latency) {
+                reg = regs[latency_reg];
+                reg2 = regs[latency_reg + 1];
+            } else {
+                reg = regs[next_reg(counters, regs.size(), load)];
+                reg2 = op.inst->form == Form::MEM_PAIR
+                               ? regs[next_reg(counters, regs.size(), load)]
+                               : reg;
+            }
+            uint32_t offset = 0;
+            if (op.inst->form == Form::MEM || op.inst->form == Form::MEM_PAIR) {
+                offset = nr_mem++ % NR_MEM_SLOTS * MEM_STRIDE;
+            }
+            e.inst(encode(op, reg, reg2, offset));
+        }
+    }
+    //! subs x0, x0, #1; b.ne loop
+    e.inst(0xf1000400);
+    e.inst(0x54000001 | ((loop - e.size()) & 0x7ffff) << 5);
+
+    e.pair_d(true, false, 14, 48);
+    e.pair_d(true, false, 12, 32);
+    e.pair_d(true, false, 10, 16);
+    e.pair_d(true, true, 8, 64);
+    //! ret
+    e.inst(0xd65f03c0);
+    return std::move(e.code());
+}
+}  // namespace
+
+MixCode megpeak::assemble_mix(const std::vector<MixInst>& mix) {
+    MixCode ret;
+    std::vector<Op> ops;
+    for (auto&& inst : mix) {
+        auto op = resolve(inst);
+        std::string isa = op.inst->isa;
+        if (!isa.empty() &&
+            ("," + ret.isa + ",").find("," + isa + ",") == std::string::npos) {
+            ret.isa += (ret.isa.empty() ? "" : ",") + isa;
+        }
+        ret.flops += op.inst->ops * op.lanes;
+        ops.push_back(op);
+    }
+    ret.nr_passes = std::max<size_t>(
+            (MIN_LOOP_INSTS + ops.size() - 1) / ops.size(), 1);
+    ret.throughput = emit_loop(ops, ret.nr_passes, false);
+    ret.latency = emit_loop(ops, ret.nr_passes, true);
+    return ret;
+}
+#endif
+
+// vim: syntax=cpp.doxygen
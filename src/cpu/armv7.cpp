@@ -10,70 +10,83 @@
 
 #include "src/cpu/armv7.h"
 #include "src/cpu/common.h"
+#include "src/cpu/registry.h"
 
 #if MEGPEAK_ARMV7
 
-#define BENCHMARK(name, computation) \
-    benchmark(name##_throughput, name##_latency, #name, computation)
-void megpeak::armv7() {
-    //! warmup
-    for (size_t i = 0; i < 100; i++) {
-        mla_s32_throughput();
-        mla_f32_throughput();
-    }
-#if MEGPEAK_WITH_ALL_BENCHMARK
-    benchmark(nop_throughput, nop_latency, "nop", 1);
-    benchmark(eor_d_throughput, eor_d_latency, "eor_d", 2);
-    benchmark(eor_q_throughput, eor_q_latency, "eor_q", 4);
-
-    benchmark(ld1_d_throughput, ld1_d_latency, "ld1_d", 2);
-    BENCHMARK(vld1d_x2, 4);
-    benchmark(ld1_q_throughput, ld1_q_latency, "ld1_q", 4);
-    BENCHMARK(add_imm, 1);
-    BENCHMARK(add_reg, 1);
-    BENCHMARK(pld, 4);
-    benchmark(st1_d_throughput, st1_d_latency, "st1_d", 2);
-    benchmark(ldst1_d_throughput, ldst1_d_latency, "ldst1_d", 2);
-#endif
-
-    benchmark(padal_throughput, padal_latency, "padal");
-    benchmark(padd_throughput, padd_latency, "padd");
-    benchmark(mla_s32_throughput, mla_s32_latency, "mla_s32", 8);
+MEGPEAK_REGISTER_BENCHMARK(armv7, nop, "nop", "", nullptr, 1, "extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, eor_d, "eor_d", "", nullptr, 2,
+                           "logic,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, eor_q, "eor_q", "", nullptr, 4,
+                           "logic,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, ld1_d, "ld1_d", "", nullptr, 2,
+                           "load_store,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, vld1d_x2, "vld1d_x2", "", nullptr, 4,
+                           "load_store,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, ld1_q, "ld1_q", "", nullptr, 4,
+                           "load_store,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, add_imm, "add_imm", "", nullptr, 1,
+                           "int32,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, add_reg, "add_reg", "", nullptr, 1,
+                           "int32,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, pld, "pld", "", nullptr, 4,
+                           "load_store,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, st1_d, "st1_d", "", nullptr, 2,
+                           "load_store,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, ldst1_d, "ldst1_d", "", nullptr, 2,
+                           "load_store,extended")
 
-#if MEGPEAK_WITH_ALL_BENCHMARK
-    BENCHMARK(vmovl_s8, 8);
-    BENCHMARK(mla_s16, 16);
-    BENCHMARK(mla_s16_lane, 16);
-    BENCHMARK(mla_s16_lane_d, 8);
-    BENCHMARK(ldrd_mla_s16_lane, 16);
-    BENCHMARK(ldrd_mla_s16_lane_1_4, 16);
+MEGPEAK_REGISTER_BENCHMARK(armv7, padal, "padal", "", nullptr, 4, "int8")
+MEGPEAK_REGISTER_BENCHMARK(armv7, padd, "padd", "", nullptr, 4, "int32")
+MEGPEAK_REGISTER_BENCHMARK(armv7, mla_s32, "mla_s32", "", nullptr, 8, "int32")
+MEGPEAK_REGISTER_BENCHMARK(armv7, vmovl_s8, "vmovl_s8", "", nullptr, 8,
+                           "int8,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, mla_s16, "mla_s16", "", nullptr, 16,
+                           "int16,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, mla_s16_lane, "mla_s16_lane", "", nullptr, 16,
+                           "int16,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, mla_s16_lane_d, "mla_s16_lane_d", "", nullptr,
+                           8, "int16,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, ldrd_mla_s16_lane, "ldrd_mla_s16_lane", "",
+                           nullptr, 16, "int16,load_store,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, ldrd_mla_s16_lane_1_4,
+                           "ldrd_mla_s16_lane_1_4", "", nullptr, 16,
+                           "int16,load_store,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, ld1d_mlad_s16, "ld1d_mlad_s16", "", nullptr,
+                           8, "int16,load_store,extended")
 
-    benchmark(ld1d_mlad_s16_throughput, ld1d_mlad_s16_latency, "ld1d_mlad_s16",
-              8);
-#endif
-
-    benchmark(mlal_s8_throughput, mlal_s8_latency, "mlal_s8", 16);
-    benchmark(mlal_s16_throughput, mlal_s16_latency, "mlal_s16", 8);
+MEGPEAK_REGISTER_BENCHMARK(armv7, mlal_s8, "mlal_s8", "", nullptr, 16, "int8")
+MEGPEAK_REGISTER_BENCHMARK(armv7, mlal_s16, "mlal_s16", "", nullptr, 8, "int16")
+MEGPEAK_REGISTER_BENCHMARK(armv7, mlal_s16_lane, "mlal_s16_lane", "", nullptr,
+                           8, "int16")
+MEGPEAK_REGISTER_BENCHMARK(armv7, mla_f32, "mla_f32", "", nullptr, 8, "fp32")
+MEGPEAK_REGISTER_BENCHMARK(armv7, mla_f32_d, "mla_f32_d", "", nullptr, 4,
+                           "fp32,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, mla_f32d_lane, "mla_f32d_lane", "", nullptr,
+                           4, "fp32,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, mla_f32q_lane, "mla_f32q_lane", "", nullptr,
+                           8, "fp32,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, ld1d_fmlad, "ld1d_fmlad", "", nullptr, 4,
+                           "fp32,load_store,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, ld1d_fmlaq, "ld1d_fmlaq", "", nullptr, 8,
+                           "fp32,load_store,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, ld1dx2_fmlad_lane, "ld1dx2_fmlad_lane", "",
+                           nullptr, 4, "fp32,load_store,extended")
+MEGPEAK_REGISTER_BENCHMARK(armv7, ld1dx2_fmlaq_lane, "ld1dx2_fmlaq_lane", "",
+                           nullptr, 8, "fp32,load_store,extended")
 
-    benchmark(mlal_s16_lane_throughput, mlal_s16_lane_latency, "mlal_s16_lane",
-              8);
+MEGPEAK_REGISTER_BENCHMARK(armv7, mul_s32, "mul_s32", "", nullptr, 4, "int32")
+MEGPEAK_REGISTER_BENCHMARK(armv7, mul_f32, "mul_f32", "", nullptr, 4, "fp32")
+MEGPEAK_REGISTER_BENCHMARK(armv7, cvt, "cvt", "", nullptr, 4, "fp32")
+MEGPEAK_REGISTER_BENCHMARK(armv7, qrdmulh, "qrdmulh", "", nullptr, 4, "int16")
+MEGPEAK_REGISTER_BENCHMARK(armv7, rshl, "rshl", "", nullptr, 4, "int32")
 
-    benchmark(mla_f32_throughput, mla_f32_latency, "mla_f32", 8);
-#if MEGPEAK_WITH_ALL_BENCHMARK
-    benchmark(mla_f32_d_throughput, mla_f32_d_latency, "mla_f32_d", 4);
-    BENCHMARK(mla_f32d_lane, 4);
-    BENCHMARK(mla_f32q_lane, 8);
-    BENCHMARK(ld1d_fmlad, 4);
-    BENCHMARK(ld1d_fmlaq, 8);
-    BENCHMARK(ld1dx2_fmlad_lane, 4);
-    BENCHMARK(ld1dx2_fmlaq_lane, 8);
-#endif
+MEGPEAK_REGISTER_ILP_SWEEP(armv7, mla_f32, "mla_f32")
+MEGPEAK_REGISTER_ILP_SWEEP(armv7, mla_s32, "mla_s32")
+MEGPEAK_REGISTER_ILP_SWEEP(armv7, mla_s16, "mla_s16")
 
-    benchmark(mul_s32_throughput, mul_s32_latency, "mul_s32");
-    benchmark(mul_f32_throughput, mul_f32_latency, "mul_f32");
-    benchmark(cvt_throughput, cvt_latency, "cvt");
-    benchmark(qrdmulh_throughput, qrdmulh_latency, "qrdmulh");
-    benchmark(rshl_throughput, rshl_latency, "rshl");
+void megpeak::armv7() {
+    run_benchmarks(select_benchmarks("armv7"));
 }
 #else
 void megpeak::armv7() {}
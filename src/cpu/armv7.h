@@ -19,7 +19,7 @@
 #define eor(i) "veor.32 q" #i ", q" #i ", q" #i "\n"
 // clang-format off
 #define THROUGHPUT0(cb, func, start)                                        \
-    static int func##_throughput() {                                        \
+    static size_t func##_throughput(size_t runs) {                          \
         asm volatile(                                                       \
         UNROLL_CALL##start(10, eor)                                         \
         "mov r0, #0\n"                                                      \
@@ -29,14 +29,14 @@
         "cmp r0, %[RUNS] \n"                                                \
         "blt 1b \n"                                                         \
         :                                                                   \
-        : [RUNS] "r"(megpeak::RUNS)                                         \
+        : [RUNS] "r"(runs)                                                  \
         : "cc", "q0", "q1", "q2", "q3", "q4", "q5", "q6", "q7", "q8", "q9", \
           "r0", "r1");                                                      \
-        return megpeak::RUNS * 10;                                          \
+        return runs * 10;                                                   \
     }
 
 #define THROUGHPUT_MEM_N(cb, func, iter_number)                             \
-    static int func##_throughput() {                                        \
+    static size_t func##_throughput(size_t runs) {                          \
         const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());   \
         asm volatile(                                                       \
         UNROLL_CALL(10, eor)                                                \
@@ -47,17 +47,17 @@
         "cmp r10, %[RUNS] \n"                                               \
         "blt 1b \n"                                                         \
         :                                                                   \
-        : [RUNS] "r"(megpeak::RUNS),  [a_ptr] "r"(a_ptr)                    \
+        : [RUNS] "r"(runs),  [a_ptr] "r"(a_ptr)                             \
         : "cc", "q0", "q1", "q2", "q3", "q4", "q5", "q6", "q7", "q8", "q9", \
         "q10", "q11", "r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7", "r8", \
         "r9", "r10",  "memory");                                            \
-        return megpeak::RUNS * iter_number;                                 \
+        return runs * iter_number;                                          \
     }
 
 #define THROUGHPUT_MEM(cb, func) THROUGHPUT_MEM_N(cb, func, 10)
 
 #define THROUGHPUT_MEM_START6(cb, func)                                     \
-    static int func##_throughput() {                                        \
+    static size_t func##_throughput(size_t runs) {                          \
         const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());   \
         asm volatile(                                                       \
         UNROLL_CALL_START6(10, eor)                                         \
@@ -68,31 +68,48 @@
         "cmp r10, %[RUNS] \n"                                               \
         "blt 1b \n"                                                         \
         :                                                                   \
-        : [RUNS] "r"(megpeak::RUNS),  [a_ptr] "r"(a_ptr)                    \
+        : [RUNS] "r"(runs),  [a_ptr] "r"(a_ptr)                             \
         : "cc", "q0", "q1", "q2", "q3", "q4", "q5", "q6", "q7", "q8", "q9", \
         "q10", "q11", "q12", "q13", "q14", "q15", "r0", "r1", "r2", "r3",   \
         "r4", "r5", "r6", "r7", "r8", "r9", "r10",  "memory");              \
-        return megpeak::RUNS * 10;                                          \
+        return runs * 10;                                                   \
     }
 
-#define LATENCY(cb, func)              \
-    static int func##_latency() {      \
-        asm volatile(                  \
-        "veor.32 q0, q0, q0\n"         \
-        "mov r0, #0\n"                 \
-        "1:\n"                         \
-        UNROLL_CALL(10, cb)            \
-        "add  r0, r0, #1 \n"           \
-        "cmp r0, %[RUNS] \n"           \
-        "blt 1b \n"                    \
-        :                              \
-        : [RUNS] "r"(megpeak::RUNS)    \
-        : "cc", "q0", "r0");           \
-        return megpeak::RUNS * 10;     \
+#define LATENCY(cb, func)                       \
+    static size_t func##_latency(size_t runs) { \
+        asm volatile(                           \
+        "veor.32 q0, q0, q0\n"                  \
+        "mov r0, #0\n"                          \
+        "1:\n"                                  \
+        UNROLL_CALL(10, cb)                     \
+        "add  r0, r0, #1 \n"                    \
+        "cmp r0, %[RUNS] \n"                    \
+        "blt 1b \n"                             \
+        :                                       \
+        : [RUNS] "r"(runs)                      \
+        : "cc", "q0", "r0");                    \
+        return runs * 10;                       \
+    }
+
+#define ILP(cb, func, chains)                                               \
+    static size_t func##_chains##chains(size_t runs) {                      \
+        asm volatile(                                                       \
+        UNROLL_CALL(chains, eor)                                            \
+        "mov r0, #0\n"                                                      \
+        "1:\n"                                                              \
+        ILP_BODY(chains, cb)                                                \
+        "add  r0, r0, #1 \n"                                                \
+        "cmp r0, %[RUNS] \n"                                                \
+        "blt 1b \n"                                                         \
+        :                                                                   \
+        : [RUNS] "r"(runs)                                                  \
+        : "cc", "q0", "q1", "q2", "q3", "q4", "q5", "q6", "q7", "q8", "q9", \
+          "q10", "q11", "q12", "q13", "q14", "q15", "r0");                  \
+        return runs * chains * ILP_CHAIN_LENGTH;                            \
     }
 
 #define LATENCY_MEM(cb, func)                                             \
-    static int func##_latency() {                                         \
+    static size_t func##_latency(size_t runs) {                           \
         const float* a_ptr = reinterpret_cast<float*>(get_mem_align64()); \
         asm volatile(                                                     \
         "veor.32 q0, q0, q0\n"                                            \
@@ -103,9 +120,9 @@
         "cmp r0, %[RUNS] \n"                                              \
         "blt 1b \n"                                                       \
         :                                                                 \
-        : [RUNS] "r"(megpeak::RUNS),  [a_ptr] "r"(a_ptr)                  \
+        : [RUNS] "r"(runs),  [a_ptr] "r"(a_ptr)                           \
         : "cc", "q0", "r0", "r1");                                        \
-        return megpeak::RUNS * 10;                                        \
+        return runs * 10;                                                 \
     }
 // clang-format on
 #define THROUGHPUT(cb, func) THROUGHPUT0(cb, func, )
@@ -153,7 +170,7 @@ THROUGHPUT_MEM(cb, ld1_d)
 LATENCY_MEM(cb, ld1_d)
 #undef cb
 
-static int vld1d_x2_throughput() {
+static size_t vld1d_x2_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
     asm volatile(                                                       
         UNROLL_CALL(10, eor)                                        
@@ -173,10 +190,10 @@ static int vld1d_x2_throughput() {
         "cmp r0, %[RUNS] \n"                                        
         "blt 1b \n"                                                 
         :                                                           
-        : [RUNS] "r"(megpeak::RUNS),  [a_ptr] "r"(a_ptr)            
+        : [RUNS] "r"(runs),  [a_ptr] "r"(a_ptr)            
         : "cc", "q0", "q1", "q2", "q3", "q4", "q5", "q6", "q7", "q8", "q9",
         "q10", "q11", "r0","r1", "memory");
-    return megpeak::RUNS * 10;
+    return runs * 10;
 }
 
 #define cb(i) "vld1.32 {d0, d1}, [%[a_ptr]]\n"
@@ -233,6 +250,7 @@ LATENCY(cb, padal)
 
 #define cb(i) "vmla.s32 q" #i ", q" #i ", q" #i "\n"
 THROUGHPUT(cb, mla_s32)
+ILP_SWEEP(cb, mla_s32)
 #undef cb
 #define cb(i) "vmla.s32 q0, q0, q0\n"
 LATENCY(cb, mla_s32)
@@ -240,6 +258,7 @@ LATENCY(cb, mla_s32)
 
 #define cb(i) "vmla.s16 q" #i ", q" #i ", q" #i "\n"
 THROUGHPUT(cb, mla_s16)
+ILP_SWEEP(cb, mla_s16)
 #undef cb
 #define cb(i) "vmla.s16 q0, q0, q0\n"
 LATENCY(cb, mla_s16)
@@ -280,7 +299,7 @@ THROUGHPUT_START6(cb, mla_s16_lane_d)
 LATENCY(cb, mla_s16_lane_d)
 #undef cb
 
-static int ldrd_mla_s16_lane_throughput() {
+static size_t ldrd_mla_s16_lane_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
     asm volatile(                                                       
         UNROLL_CALL(10, eor)                                        
@@ -310,10 +329,10 @@ static int ldrd_mla_s16_lane_throughput() {
         "cmp r0, %[RUNS] \n"                                        
         "blt 1b \n"                                                 
         :                                                           
-        : [RUNS] "r"(megpeak::RUNS),  [a_ptr] "r"(a_ptr)            
+        : [RUNS] "r"(runs),  [a_ptr] "r"(a_ptr)            
         : "cc", "q0", "q1", "q2", "q3", "q4", "q5", "q6", "q7", "q8", "q9",
         "q10", "q11", "r0","r1", "memory");
-    return megpeak::RUNS * 10;
+    return runs * 10;
 }
 
 #define cb(i)                    \
@@ -322,7 +341,7 @@ static int ldrd_mla_s16_lane_throughput() {
 LATENCY_MEM(cb, ldrd_mla_s16_lane)
 #undef cb
 
-static int ldrd_mla_s16_lane_1_4_throughput() {
+static size_t ldrd_mla_s16_lane_1_4_throughput(size_t runs) {
     const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
     asm volatile(                                                       
         UNROLL_CALL(10, eor)                                        
@@ -350,10 +369,10 @@ static int ldrd_mla_s16_lane_1_4_throughput() {
         "cmp r0, %[RUNS] \n"                                        
         "blt 1b \n"                                                 
         :                                                           
-        : [RUNS] "r"(megpeak::RUNS),  [a_ptr] "r"(a_ptr)            
+        : [RUNS] "r"(runs),  [a_ptr] "r"(a_ptr)            
         : "cc", "q0", "q1", "q2", "q3", "q4", "q5", "q6", "q7", "q8", "q9",
         "q10", "q11", "q12", "q13", "r0","r1", "memory");
-    return megpeak::RUNS * 12;
+    return runs * 12;
 }
 
 #define cb(i)                    \
@@ -447,6 +466,7 @@ LATENCY(cb, mla_f32d_lane)
 
 #define cb(i) "vmla.f32 q" #i ", q" #i ", q" #i "\n"
 THROUGHPUT(cb, mla_f32)
+ILP_SWEEP(cb, mla_f32)
 #undef cb
 #define cb(i) "vmla.f32 q0, q0, q0\n"
 LATENCY(cb, mla_f32)
@@ -16,7 +16,12 @@
 #include <string.h>
 #include <sys/syscall.h>
 #include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #ifdef __APPLE__
 #include <mach/mach.h>
@@ -28,6 +33,20 @@
 
 #include "src/backend.h"
 #include "src/cpu/common.h"
+#include "src/cpu/cycle_counter.h"
+#include "src/cpu/frequency.h"
+#include "src/cpu/jit.h"
+#include "src/cpu/loop_overhead.h"
+#include "src/cpu/memory_latency.h"
+#include "src/cpu/multi_core.h"
+#include "src/cpu/perf_event.h"
+#include "src/cpu/port_mapping.h"
+#include "src/cpu/registry.h"
+#include "src/cpu/stream.h"
+#include "src/cpu/topology.h"
+#include "src/options.h"
+#include "src/report.h"
+#include "src/statistics.h"
 
 #ifdef MEGPEAK_USE_CPUINFO
 #include "cpuinfo.h"
@@ -35,44 +54,112 @@
 
 using namespace megpeak;
 namespace {
-uint8_t bandwidth() {
-    constexpr size_t NR_WARMUP = 5, NR_RUNS = 40, NR_BYTES = 1024 * 1024 * 100;
-    std::unique_ptr<uint8_t[]> src{new uint8_t[NR_BYTES]{}};
-    std::unique_ptr<uint8_t[]> dst{new uint8_t[NR_BYTES]{}};
+//! round trips of the cache line in every sample of core_to_core_latency()
+constexpr size_t NR_ROUND_TRIPS = 10000;
 
-    volatile uint8_t res = 0;
-    for (size_t i = 0; i < NR_WARMUP; i++) {
-        memcpy(dst.get(), src.get(), NR_BYTES);
-        res += dst[0];
-    }
+//! a cache line of its own, so that nothing else moves with it
+struct alignas(64) CacheLine {
+    std::atomic<size_t> value{0};
+};
 
-    Timer timer;
-    for (size_t i = 0; i < NR_RUNS; i++) {
-        memcpy(dst.get(), src.get(), NR_BYTES);
-        res += dst[0];
-    }
-    float used = timer.get_msecs() / NR_RUNS;
-    printf("bandwidth: %f Gbps\n",
-           2 * NR_BYTES / (1024.0 * 1024.0 * 1024.0) * 1000 / used);
-    return res;
+/**
+ * ns of a round trip of a cache line between two cores, the thread on ping
+ * stores an odd value and waits for the thread on pong to answer with the
+ * next even one, each store moves the line to the other core. The first
+ * sample is a warm-up and dropped
+ */
+Statistics cache_line_round_trip(size_t ping, size_t pong) {
+    size_t nr_samples = std::max<size_t>(get_options().nr_samples, 1);
+    size_t nr_round_trips = (nr_samples + 1) * NR_ROUND_TRIPS;
+    CacheLine line;
+    std::vector<double> nsecs;
+    std::thread responder([&] {
+        megpeak_assert(cpu_set_affinity(pong) != -1,
+                       "Set CPU core affinity(%zu) failed.", pong);
+        for (size_t i = 0; i < nr_round_trips; i++) {
+            size_t expected = 2 * i + 1;
+            while (line.value.load(std::memory_order_acquire) != expected) {
+            }
+            line.value.store(expected + 1, std::memory_order_release);
+        }
+    });
+    std::thread initiator([&] {
+        megpeak_assert(cpu_set_affinity(ping) != -1,
+                       "Set CPU core affinity(%zu) failed.", ping);
+        size_t value = 1;
+        for (size_t sample = 0; sample <= nr_samples; sample++) {
+            Timer timer;
+            for (size_t i = 0; i < NR_ROUND_TRIPS; i++, value += 2) {
+                line.value.store(value, std::memory_order_release);
+                while (line.value.load(std::memory_order_acquire) !=
+                       value + 1) {
+                }
+            }
+            if (sample) {
+                nsecs.push_back(timer.get_nsecs() / NR_ROUND_TRIPS);
+            }
+        }
+    });
+    initiator.join();
+    responder.join();
+    return compute_statistics(nsecs);
 }
 
-int cpu_set_affinity(int dev_id) {
-#if defined(__APPLE__)
-#pragma message("set_cpu_affinity not enabled on apple platform")
-  printf("WARNING: cpu core affinity is not usable in apple os\n");
-  return 0;
-#else
-    cpu_set_t cst;
-    CPU_ZERO(&cst);
-    CPU_SET(dev_id, &cst);
-    return sched_setaffinity(0, sizeof(cst), &cst);
-#endif
-}
+//! the round trip latency of a cache line between every pair of the cores of
+//! --cores, all the online cores if it is not given, as an N x N matrix
+void core_to_core_latency() {
+    auto cores = get_options().cores;
+    if (cores.empty()) {
+        cores = get_online_cpus();
+    }
+    size_t nr_cores = cores.size();
+    if (nr_cores < 2) {
+        printf("core to core latency: needs 2 cores at least, there is "
+               "%zu\n\n",
+               nr_cores);
+        return;
+    }
+    std::vector<std::vector<double>> matrix(nr_cores,
+                                            std::vector<double>(nr_cores, 0));
+    for (size_t i = 0; i < nr_cores; i++) {
+        for (size_t j = 0; j < nr_cores; j++) {
+            if (cores[i] == cores[j]) {
+                continue;
+            }
+            auto stats = cache_line_round_trip(cores[i], cores[j]);
+            matrix[i][j] = stats.median;
+            report_result("core_to_core",
+                          "core" + std::to_string(cores[i]) + "_core" +
+                                  std::to_string(cores[j]),
+                          "", "round_trip", "ns", stats);
+        }
+    }
 
-size_t get_cpu_count() {
-    size_t cpu_num = sysconf(_SC_NPROCESSORS_ONLN);
-    return cpu_num;
+    printf("core to core round trip latency of a cache line in ns, from the "
+           "core of the row to the core of the column and back\n");
+    printf("%6s", "");
+    for (auto core : cores) {
+        printf(" %6zu", core);
+    }
+    printf("\n");
+    double min = 0, max = 0;
+    for (size_t i = 0; i < nr_cores; i++) {
+        printf("%6zu", cores[i]);
+        for (size_t j = 0; j < nr_cores; j++) {
+            if (cores[i] == cores[j]) {
+                printf(" %6s", "-");
+                continue;
+            }
+            printf(" %6.1f", matrix[i][j]);
+            min = min == 0 ? matrix[i][j] : std::min(min, matrix[i][j]);
+            max = std::max(max, matrix[i][j]);
+        }
+        printf("\n");
+    }
+    if (min > 0) {
+        printf("min %.1f ns, max %.1f ns, %.2fx\n", min, max, max / min);
+    }
+    printf("\n");
 }
 
 #ifdef MEGPEAK_USE_CPUINFO
@@ -350,24 +437,334 @@ void print_cpu_info(size_t dev_id, size_t cpu_count)
     printf("Vendor is: %s, uArch: %s, frequency: %ldHz\n", vendor_string,
            uarch_string, core->frequency);
 #endif // MEGPEAK_USE_CPUINFO
+    printf("cycle counter: %s\n", get_cycle_counter().name().c_str());
+    auto&& overhead = get_loop_overhead();
+    if (overhead.nsecs > 0) {
+        printf("empty loop: %f ns %f %s per iteration\n", overhead.nsecs,
+               overhead.cycles,
+               get_cycle_counter().is_core_clock() ? "cycle" : "tick");
+    }
+    if (auto pmu = get_pmu_group()) {
+        printf("pmu events:");
+        for (auto&& name : pmu->names()) {
+            printf(" %s", name.c_str());
+        }
+        printf("\n");
+    }
+    printf("\n");
+}
+
+//! the co-issue matrix of the selected entries of all the suites with a mix
+void run_pairs() {
+    std::vector<std::string> names, mixes;
+    for (auto&& entry : BenchmarkRegistry::instance().entries()) {
+        if (!entry.mix.empty() && entry.is_supported() &&
+            is_selected(entry.name, entry.tags)) {
+            names.push_back(entry.name);
+            mixes.push_back(entry.mix);
+        }
+    }
+    co_issue_matrix(names, mixes);
+}
+
+//! every pair of the selected entries of all the suites on smt siblings
+void run_smt(size_t core) {
+    std::vector<const BenchmarkEntry*> entries;
+    for (auto&& entry : BenchmarkRegistry::instance().entries()) {
+        if (entry.is_supported() && is_selected(entry.name, entry.tags)) {
+            entries.push_back(&entry);
+        }
+    }
+    smt_interference(entries, core);
+}
+
+//! frequency change between the probes before and after a suite to warn about
+constexpr float FREQUENCY_DIFF_THRESHOLD = 0.05;
+
+//! run the benchmark suite with a frequency probe before and after it, so
+//! that turbo, avx frequency offset and thermal throttling are visible
+void run_suite(const char* name, void (*suite)()) {
+    if (select_benchmarks(name).empty()) {
+        return;
+    }
+    double before = measure_frequency();
+    printf("%s: core frequency before suite: %.0f MHz\n", name, before);
+    suite();
+    double after = measure_frequency();
+    printf("%s: core frequency after suite: %.0f MHz\n", name, after);
+    if (get_relative_diff(before, after) > FREQUENCY_DIFF_THRESHOLD) {
+        printf("WARNING: core frequency changed from %.0f MHz to %.0f MHz "
+               "during %s, the results may be disturbed by turbo or "
+               "throttling\n",
+               before, after, name);
+    }
     printf("\n");
 }
 
+//! the STREAM bandwidth and the suites of the arch, selected by --filter
+void run_suites() {
+    for (auto pages : get_page_sizes()) {
+        stream_bandwidth(pages);
+    }
+#if MEGPEAK_AARCH64
+    run_suite("aarch64", aarch64);
+#elif MEGPEAK_ARMV7
+    run_suite("armv7", armv7);
+#elif MEGPEAK_X86
+    run_suite("x86_avx", x86_avx);
+    run_suite("x86_sse", x86_sse);
+#elif MEGPEAK_LOONGARCH
+    run_suite("loongarch_lasx", loongarch_lasx);
+#endif
+}
+
+//! relative difference of the signatures of two cores to be in one cluster
+constexpr double CLUSTER_DIFF_THRESHOLD = 0.1;
+//! time of one probe of the signature of a core
+constexpr double SIGNATURE_PROBE_MS = 10;
+
+//! a core of --all-cores with what is measured on it
+struct CoreSample {
+    CoreInfo info;
+    double frequency;
+    //! ns per instruction of the throughput and the latency kernel of the
+    //! first fma benchmark, 0 if there is none
+    double throughput = 0, latency = 0;
+};
+
+//! median ns per instruction of the kernel over a few short probes
+double probe_nsecs(const KernelFunc& func) {
+    warm_up(func);
+    size_t nr_runs = calibrate_runs(func, SIGNATURE_PROBE_MS);
+    std::vector<double> nsecs;
+    for (size_t i = 0; i < 3; i++) {
+        Timer timer;
+        auto insts = func(nr_runs);
+        nsecs.push_back(timer.get_nsecs() / insts);
+    }
+    std::sort(nsecs.begin(), nsecs.end());
+    return nsecs[1];
+}
+
+//! the first fma benchmark supported by the cpu, nullptr if none
+const BenchmarkEntry* signature_entry() {
+    for (auto&& entry : BenchmarkRegistry::instance().entries()) {
+        if (entry.has_tag("fma") && entry.is_supported()) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+CoreSample sample_core(size_t cpu, const BenchmarkEntry* entry) {
+    CoreSample ret;
+    ret.info = read_core_info(cpu);
+    ret.frequency = measure_frequency();
+    if (entry) {
+        ret.throughput = probe_nsecs(entry->throughput);
+        ret.latency = probe_nsecs(entry->latency);
+    }
+    return ret;
+}
+
+//! whether two measurements are within CLUSTER_DIFF_THRESHOLD, unlike
+//! get_relative_diff() this does not floor the base at 1, the ns per
+//! instruction are below it
+bool is_close(double lhs, double rhs) {
+    double base = std::max(lhs, rhs);
+    return base <= 0 || std::fabs(lhs - rhs) / base < CLUSTER_DIFF_THRESHOLD;
+}
+
+//! cores of a cluster share the package, the cpufreq limit and the speed
+bool same_cluster(const CoreSample& lhs, const CoreSample& rhs) {
+    return lhs.info.package_id == rhs.info.package_id &&
+           lhs.info.max_freq == rhs.info.max_freq &&
+           is_close(lhs.frequency, rhs.frequency) &&
+           is_close(lhs.throughput, rhs.throughput) &&
+           is_close(lhs.latency, rhs.latency);
+}
+
+/**
+ * sample every online core, group the cores into clusters and run the
+ * suites on the first core of each cluster. sysfs alone does not tell the
+ * cores of big.LITTLE and hybrid x86 apart on every kernel, so the frequency
+ * and the throughput/latency of a fma kernel are measured on each core too
+ */
+void run_all_cores(size_t dev_id) {
+    auto entry = signature_entry();
+    std::vector<CoreSample> samples;
+    for (auto cpu : get_online_cpus()) {
+        if (cpu_set_affinity(cpu) == -1) {
+            printf("core %zu: can not be pinned, skipped\n", cpu);
+            continue;
+        }
+        auto sample = sample_core(cpu, entry);
+        printf("core %zu: package %d cluster %d core %d, max %.0f MHz, "
+               "measured %.0f MHz",
+               cpu, sample.info.package_id, sample.info.cluster_id,
+               sample.info.core_id, sample.info.max_freq, sample.frequency);
+        if (entry) {
+            printf(", %s throughput %.3f ns latency %.3f ns",
+                   entry->name.c_str(), sample.throughput, sample.latency);
+        }
+        printf("\n");
+        samples.push_back(sample);
+    }
+    megpeak_assert(!samples.empty(), "%s", "no core can be pinned");
+
+    std::vector<std::vector<CoreSample>> clusters;
+    for (auto&& sample : samples) {
+        auto it = std::find_if(clusters.begin(), clusters.end(),
+                               [&](const std::vector<CoreSample>& cluster) {
+                                   return same_cluster(cluster[0], sample);
+                               });
+        if (it == clusters.end()) {
+            clusters.push_back({sample});
+        } else {
+            it->push_back(sample);
+        }
+    }
+    printf("\n%zu clusters of %zu cores\n\n", clusters.size(),
+           samples.size());
+
+    auto sink = get_result_sink();
+    for (size_t i = 0; i < clusters.size(); i++) {
+        auto&& cluster = clusters[i];
+        std::vector<size_t> cpus;
+        std::vector<int> cluster_ids;
+        for (auto&& sample : cluster) {
+            cpus.push_back(sample.info.cpu);
+            if (std::find(cluster_ids.begin(), cluster_ids.end(),
+                          sample.info.cluster_id) == cluster_ids.end()) {
+                cluster_ids.push_back(sample.info.cluster_id);
+            }
+        }
+        std::string ids;
+        for (auto id : cluster_ids) {
+            ids += (ids.empty() ? "" : ",") + std::to_string(id);
+        }
+        auto&& first = cluster[0];
+        std::string name = "cluster" + std::to_string(i);
+        printf("%s: cores %s, package %d, cluster_id %s, max %.0f MHz, "
+               "measured %.0f MHz\n",
+               name.c_str(), format_cpu_list(cpus).c_str(),
+               first.info.package_id, ids.c_str(), first.info.max_freq,
+               first.frequency);
+        report_result("clusters", name, "", "nr_cores", "cores",
+                      static_cast<double>(cpus.size()));
+        report_result("clusters", name, "", "frequency", "MHz",
+                      first.frequency);
+        if (entry) {
+            report_result("clusters", name, entry->isa, "throughput", "ns",
+                          first.throughput);
+            report_result("clusters", name, entry->isa, "latency", "ns",
+                          first.latency);
+        }
+        megpeak_assert(cpu_set_affinity(first.info.cpu) != -1,
+                       "Set CPU core affinity(%zu) failed.", first.info.cpu);
+        if (sink) {
+            sink->set_scope(name);
+        }
+        run_suites();
+    }
+    if (sink) {
+        sink->set_scope("");
+    }
+    megpeak_assert(cpu_set_affinity(dev_id) != -1,
+                   "Set CPU core affinity(%zu) failed.", dev_id);
+}
+
 }  // namespace
 
 void CPUBackend::execute() {
+    if (get_options().list) {
+        list_benchmarks();
+        return;
+    }
     size_t cpu_count = get_cpu_count();
     if (cpu_set_affinity(m_dev_id) == -1) {
       fprintf(stderr, "ERROR: Set CPU core affinity(%zu) failed.\n", m_dev_id);
       exit(1);
     }
+    auto& cores = get_options().cores;
+    size_t nr_threads = get_options().nr_threads;
+    //! the online cpus may have holes, e.g. with cores taken offline
+    auto online = get_online_cpus();
+    if (cores.empty() && nr_threads) {
+        auto first = std::find(online.begin(), online.end(), m_dev_id);
+        megpeak_assert(first != online.end() &&
+                               size_t(online.end() - first) >= nr_threads,
+                       "%zu threads from core %zu, but the online cores are "
+                       "%s",
+                       nr_threads, m_dev_id, format_cpu_list(online).c_str());
+        cores.assign(first, first + nr_threads);
+    }
+    for (auto core : cores) {
+        megpeak_assert(std::find(online.begin(), online.end(), core) !=
+                               online.end(),
+                       "core %zu of --cores is not online", core);
+    }
+    megpeak_assert(cores.empty() || !get_options().all_cores, "%s",
+                   "--all-cores can not be used with --threads/--cores");
     print_cpu_info(m_dev_id, cpu_count);
-    bandwidth();
-    aarch64();
-    armv7();
-    x86_avx();
-    x86_sse();
-    loongarch_lasx();
+    if (auto sink = get_result_sink()) {
+        auto&& env = sink->environment();
+        env.backend = "cpu";
+        env.device_id = m_dev_id;
+        env.device_name = env.cpu_model;
+    }
+    if (!get_options().mix.empty()) {
+        run_mix(get_options().mix);
+        return;
+    }
+    if (!get_options().ports.empty()) {
+        infer_port_mapping(get_options().ports);
+        return;
+    }
+    if (!get_options().ratio.empty()) {
+        ratio_sweep(get_options().ratio);
+        return;
+    }
+    if (get_options().pairs) {
+        run_pairs();
+        return;
+    }
+    if (get_options().smt) {
+        run_smt(m_dev_id);
+        return;
+    }
+    if (get_options().core_to_core) {
+        core_to_core_latency();
+        return;
+    }
+    if (get_options().sweep_max_bytes) {
+        for (auto pages : get_page_sizes()) {
+            bandwidth_sweep(get_options().sweep_max_bytes, pages);
+        }
+        return;
+    }
+    if (get_options().latency_max_bytes) {
+        for (auto pages : get_page_sizes()) {
+            memory_latency(get_options().latency_max_bytes, pages);
+        }
+        return;
+    }
+    if (get_options().tlb_max_bytes) {
+        //! the small and the huge pages by default, the point of the sweep
+        auto page_sizes = get_options().pages.empty()
+                                  ? std::vector<PageSize>{PageSize::SMALL,
+                                                          PageSize::THP}
+                                  : get_page_sizes();
+        for (auto pages : page_sizes) {
+            tlb_reach(get_options().tlb_max_bytes, pages);
+        }
+        return;
+    }
+    if (get_options().all_cores) {
+        run_all_cores(m_dev_id);
+        return;
+    }
+    run_suites();
 }
 
 // vim: syntax=cpp.doxygen
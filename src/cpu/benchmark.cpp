@@ -0,0 +1,327 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#include "src/backend.h"
+#include "src/cpu/common.h"
+#include "src/cpu/cycle_counter.h"
+#include "src/cpu/frequency.h"
+#include "src/cpu/loop_overhead.h"
+#include "src/cpu/perf_event.h"
+#include "src/options.h"
+#include "src/report.h"
+#include "src/statistics.h"
+
+using namespace megpeak;
+
+namespace {
+//! per instruction cost of a kernel, in ns and in cycles of the cycle counter
+struct Measurement {
+    Statistics nsecs;
+    Statistics cycles;
+    //! per instruction value of each event of the pmu group
+    std::vector<std::string> pmu_names;
+    std::vector<Statistics> pmu;
+    WarmupResult warmup;
+    //! per instruction share of the loop tail, see get_loop_overhead()
+    double loop_nsecs = 0;
+};
+
+//! the largest factor the loop count grows by between two calibration probes
+constexpr double MAX_CALIBRATION_SCALE = 10;
+//! time of one warm-up probe relative to the time of one sample
+constexpr double WARMUP_PROBE_RATIO = 0.1;
+//! number of successive stable probes after which the warm-up stops
+constexpr size_t NR_STABLE_PROBES = 3;
+//! the ilp sweep is saturated once the throughput is within it of the best
+constexpr double ILP_SATURATION = 0.05;
+
+Measurement sample(const KernelFunc& func) {
+    size_t nr_samples = std::max<size_t>(get_options().nr_samples, 1);
+    Measurement ret;
+    ret.warmup = warm_up(func);
+    size_t nr_runs = calibrate_runs(func);
+    auto& counter = get_cycle_counter();
+    auto pmu = get_pmu_group();
+    size_t nr_events = pmu ? pmu->names().size() : 0;
+    std::vector<double> nsecs, cycles;
+    std::vector<std::vector<double>> events(nr_events);
+    size_t nr_insts = 0;
+    for (size_t i = 0; i < nr_samples; i++) {
+        if (pmu) {
+            pmu->start();
+        }
+        Timer timer;
+        counter.start();
+        auto runs = func(nr_runs);
+        nr_insts = runs;
+        uint64_t used_cycles = counter.stop();
+        nsecs.push_back(timer.get_nsecs() / runs);
+        cycles.push_back(static_cast<double>(used_cycles) / runs);
+        std::vector<uint64_t> values;
+        //! a sample in which the group was never scheduled has no counts
+        if (pmu && pmu->stop(values)) {
+            for (size_t j = 0; j < nr_events; j++) {
+                events[j].push_back(static_cast<double>(values[j]) / runs);
+            }
+        }
+    }
+    //! the kernels return the number of instructions, runs * unroll
+    double unroll = static_cast<double>(nr_insts) / nr_runs;
+    auto&& overhead = get_loop_overhead();
+    ret.loop_nsecs = overhead.nsecs / unroll;
+    ret.nsecs = compute_statistics(nsecs);
+    if (counter.valid()) {
+        ret.cycles = compute_statistics(cycles);
+    }
+    if (pmu && !events.empty() && !events[0].empty()) {
+        ret.pmu_names = pmu->names();
+        for (auto&& values : events) {
+            ret.pmu.push_back(compute_statistics(values));
+        }
+    } else if (pmu && !events.empty()) {
+        static bool warned = false;
+        if (!warned) {
+            fprintf(stderr,
+                    "WARNING: the pmu group was never scheduled, too many "
+                    "events for the counters or they are used by another "
+                    "process, continue without them\n");
+            warned = true;
+        }
+    }
+    return ret;
+}
+
+void print_statistics(const char* tag, const Statistics& stat) {
+    printf("    %s: min %f median %f mean %f stddev %f p95 %f ci95 [%f, %f] "
+           "ns, samples %zu outliers %zu\n",
+           tag, stat.min, stat.median, stat.mean, stat.stddev, stat.p95,
+           stat.ci_low, stat.ci_high, stat.nr_samples(), stat.nr_outliers);
+}
+
+void print_pmu(const char* tag, const Measurement& measurement) {
+    if (measurement.pmu.empty()) {
+        return;
+    }
+    printf("    %s pmu per inst:", tag);
+    for (size_t i = 0; i < measurement.pmu.size(); i++) {
+        printf(" %s %f", measurement.pmu_names[i].c_str(),
+               measurement.pmu[i].median);
+    }
+    printf("\n");
+}
+
+void print_loop_overhead(const Measurement& throughput,
+                         const Measurement& latency) {
+    if (get_loop_overhead().nsecs <= 0) {
+        return;
+    }
+    printf("    loop overhead per inst: throughput %f ns latency %f ns\n",
+           throughput.loop_nsecs, latency.loop_nsecs);
+}
+
+void print_warmup(const Measurement& throughput, const Measurement& latency) {
+    if (get_options().max_warmup_ms <= 0) {
+        return;
+    }
+    auto print = [](const char* tag, const WarmupResult& warmup) {
+        printf(" %s %.1f ms %zu probes%s", tag, warmup.time_ms,
+               warmup.nr_probes, warmup.converged ? "" : " (not stable)");
+    };
+    printf("    warmup:");
+    print("throughput", throughput.warmup);
+    print("latency", latency.warmup);
+    printf("\n");
+}
+
+void report_measurement(const std::string& suite, const char* inst,
+                        const std::string& isa, const char* metric,
+                        const Measurement& measurement) {
+    std::string tag = metric;
+    report_result(suite, inst, isa, tag, "ns", measurement.nsecs);
+    auto&& counter = get_cycle_counter();
+    if (counter.valid()) {
+        report_result(suite, inst, isa, tag + "_cycles",
+                      counter.is_core_clock() ? "cycle" : "tick",
+                      measurement.cycles);
+    }
+    for (size_t i = 0; i < measurement.pmu.size(); i++) {
+        report_result(suite, inst, isa, tag + "_" + measurement.pmu_names[i],
+                      "count/inst", measurement.pmu[i]);
+    }
+    if (get_loop_overhead().nsecs > 0) {
+        report_result(suite, inst, isa, tag + "_loop_overhead", "ns",
+                      measurement.loop_nsecs);
+    }
+    if (get_options().max_warmup_ms > 0) {
+        report_result(suite, inst, isa, tag + "_warmup", "ms",
+                      measurement.warmup.time_ms);
+    }
+}
+}  // namespace
+
+size_t megpeak::calibrate_runs(const KernelFunc& func) {
+    return calibrate_runs(func, get_options().min_time_ms);
+}
+
+size_t megpeak::calibrate_runs(const KernelFunc& func, double time_ms) {
+    double min_time = time_ms * 1e6;
+    //! the loop counters of the kernels may be 32 bits
+    constexpr size_t MAX_RUNS = UINT32_MAX;
+    size_t runs = 1;
+    while (runs < MAX_RUNS) {
+        Timer timer;
+        func(runs);
+        double used = timer.get_nsecs();
+        if (used >= min_time) {
+            break;
+        }
+        //! aim a bit above the target so that the next probe is the last one
+        double scale = used > 0 ? min_time * 1.1 / used : MAX_CALIBRATION_SCALE;
+        scale = std::min(scale, MAX_CALIBRATION_SCALE);
+        runs = std::min(std::max(runs + 1, static_cast<size_t>(runs * scale)),
+                        MAX_RUNS);
+    }
+    return runs;
+}
+
+WarmupResult megpeak::warm_up(const KernelFunc& func) {
+    auto&& options = get_options();
+    WarmupResult ret;
+    if (options.max_warmup_ms <= 0) {
+        return ret;
+    }
+    Timer timer;
+    size_t runs =
+            calibrate_runs(func, options.min_time_ms * WARMUP_PROBE_RATIO);
+    double last = 0;
+    size_t nr_stable = 0;
+    while (nr_stable < NR_STABLE_PROBES) {
+        if (timer.get_msecs() >= options.max_warmup_ms) {
+            ret.converged = false;
+            break;
+        }
+        Timer probe;
+        func(runs);
+        double used = probe.get_nsecs();
+        ret.nr_probes++;
+        if (last > 0 &&
+            get_relative_diff(used, last) <= options.warmup_tolerance) {
+            nr_stable++;
+        } else {
+            nr_stable = 0;
+        }
+        last = used;
+    }
+    ret.time_ms = timer.get_msecs();
+    return ret;
+}
+
+double megpeak::measure_cycles(const KernelFunc& func) {
+    auto result = sample(func);
+    if (get_cycle_counter().is_core_clock()) {
+        return result.cycles.median;
+    }
+    static double mhz = measure_frequency();
+    megpeak_assert(mhz > 0, "%s",
+                   "no cycle counter and no frequency probe on this "
+                   "architecture");
+    return result.nsecs.median * mhz / 1e3;
+}
+
+void megpeak::ilp_sweep(const std::vector<KernelFunc>& chains,
+                        const char* inst, size_t inst_simd,
+                        const std::string& suite, const std::string& isa) {
+    size_t nr_chains = std::min(get_options().ilp_chains, chains.size());
+    auto&& counter = get_cycle_counter();
+    const char* unit = counter.is_core_clock() ? "cycle" : "tick";
+    printf("%s ilp sweep:\n", inst);
+    std::vector<double> nsecs;
+    for (size_t i = 0; i < nr_chains; i++) {
+        auto result = sample(chains[i]);
+        double ns = result.nsecs.median;
+        nsecs.push_back(ns);
+        printf("    %2zu chains: %f ns", i + 1, ns);
+        if (counter.valid()) {
+            double cpi = result.cycles.median;
+            printf(" %f %s/inst %f inst/%s", cpi, unit, 1.0 / cpi, unit);
+        }
+        printf(" %f GFlops\n", 1.f / ns * inst_simd);
+        report_measurement(suite, inst, isa,
+                           ("chains" + std::to_string(i + 1)).c_str(),
+                           result);
+    }
+    if (nsecs.empty()) {
+        return;
+    }
+    double best = *std::min_element(nsecs.begin(), nsecs.end());
+    size_t saturated = 0;
+    while (nsecs[saturated] > best / (1 - ILP_SATURATION)) {
+        saturated++;
+    }
+    printf("    saturated with %zu chains, best %f GFlops\n", saturated + 1,
+           1.f / best * inst_simd);
+    report_result(suite, inst, isa, "saturation_chains", "chains",
+                  static_cast<double>(saturated + 1));
+}
+
+void megpeak::benchmark(KernelFunc throughtput_func, KernelFunc latency_func,
+                        const char* inst,
+                        double inst_simd, std::string msg,
+                        const std::string& suite, const std::string& isa) {
+    auto throughput = sample(throughtput_func);
+    auto latency = sample(latency_func);
+    auto&& counter = get_cycle_counter();
+    //! the kernels without flops, e.g. loads, only have the throughput
+    std::string gflops;
+    if (inst_simd) {
+        gflops = " " + std::to_string(1.f / throughput.nsecs.median *
+                                      inst_simd) +
+                 " GFlops";
+    }
+    if (counter.valid()) {
+        //! constant rate counters do not tick with the core clock
+        const char* unit = counter.is_core_clock() ? "cycle" : "tick";
+        double cpi = throughput.cycles.median;
+        printf("%s throughput: %f ns %f %s/inst %f inst/%s%s latency: "
+               "%f ns %f %s/inst :%s\n",
+               inst, throughput.nsecs.median, cpi, unit, 1.0 / cpi, unit,
+               gflops.c_str(), latency.nsecs.median, latency.cycles.median,
+               unit, msg.c_str());
+    } else {
+        printf("%s throughput: %f ns%s latency: %f ns :%s\n", inst,
+               throughput.nsecs.median, gflops.c_str(), latency.nsecs.median,
+               msg.c_str());
+    }
+    print_statistics("throughput", throughput.nsecs);
+    print_statistics("latency", latency.nsecs);
+    print_pmu("throughput", throughput);
+    print_pmu("latency", latency);
+    print_loop_overhead(throughput, latency);
+    print_warmup(throughput, latency);
+
+    report_measurement(suite, inst, isa, "throughput", throughput);
+    report_measurement(suite, inst, isa, "latency", latency);
+    if (!inst_simd) {
+        return;
+    }
+    std::vector<double> rates;
+    for (auto nsecs : throughput.nsecs.samples) {
+        rates.push_back(inst_simd / nsecs);
+    }
+    report_result(suite, inst, isa, "gflops", "GFlops",
+                  compute_statistics(rates));
+}
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,261 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/cpu/buffer.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#if defined(__ANDROID__) || defined(ANDROID)
+#include <malloc.h>
+#endif
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include "src/backend.h"
+#include "src/options.h"
+
+using namespace megpeak;
+
+namespace {
+constexpr size_t BASE_PAGE_SIZE = 4096;
+//! the huge page of x86-64 and of the 4K granule of aarch64/loongarch
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+void* allocate_aligned(size_t alignment, size_t bytes) {
+    void* ptr = nullptr;
+#ifdef WIN32
+    ptr = _aligned_malloc(bytes, alignment);
+#elif defined(__ANDROID__) || defined(ANDROID)
+    ptr = memalign(alignment, bytes);
+#else
+    if (posix_memalign(&ptr, alignment, bytes)) {
+        ptr = nullptr;
+    }
+#endif
+    return ptr;
+}
+
+//! a thp buffer less backed by huge pages is warned about
+constexpr double MIN_HUGE_PAGE_FRACTION = 0.9;
+
+//! madvise(MADV_HUGEPAGE) does nothing when thp is set to never
+bool is_thp_disabled() {
+    char mode[128] = {};
+    FILE* file = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if (!file) {
+        return false;
+    }
+    bool disabled = fgets(mode, sizeof(mode), file) && strstr(mode, "[never]");
+    fclose(file);
+    return disabled;
+}
+}  // namespace
+
+const char* megpeak::page_size_name(PageSize pages) {
+    switch (pages) {
+        case PageSize::SMALL:
+            return "4k";
+        case PageSize::THP:
+            return "thp";
+        case PageSize::HUGETLB:
+            return "hugetlb";
+    }
+    return "unknown";
+}
+
+size_t megpeak::page_bytes(PageSize pages) {
+    return pages == PageSize::SMALL ? BASE_PAGE_SIZE : HUGE_PAGE_SIZE;
+}
+
+bool megpeak::parse_page_size(const std::string& name, PageSize& pages) {
+    for (auto candidate : {PageSize::SMALL, PageSize::THP, PageSize::HUGETLB}) {
+        if (name == page_size_name(candidate)) {
+            pages = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<PageSize> megpeak::get_page_sizes() {
+    std::vector<PageSize> ret;
+    for (auto&& name : get_options().pages) {
+        PageSize pages;
+        megpeak_assert(parse_page_size(name, pages),
+                       "unknown page size %s, it is 4k, thp or hugetlb",
+                       name.c_str());
+        ret.push_back(pages);
+        if (pages == PageSize::THP && is_thp_disabled()) {
+            printf("WARNING: transparent huge pages are disabled, the thp "
+                   "buffers get 4k pages\n");
+        }
+    }
+    if (ret.empty()) {
+        ret.push_back(PageSize::SMALL);
+    }
+    return ret;
+}
+
+std::string megpeak::page_suite(const std::string& suite, PageSize pages) {
+    if (pages == PageSize::SMALL) {
+        return suite;
+    }
+    return suite + "_" + page_size_name(pages);
+}
+
+Buffer::Buffer(size_t bytes, PageSize pages) : m_size(bytes), m_pages(pages) {
+#if defined(__linux__)
+    if (pages == PageSize::HUGETLB) {
+        m_mapped_size =
+                (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        m_ptr = mmap(nullptr, m_mapped_size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        megpeak_assert(m_ptr != MAP_FAILED,
+                       "failed to map %zu bytes of hugetlb pages, reserve "
+                       "them in /proc/sys/vm/nr_hugepages",
+                       m_mapped_size);
+        return;
+    }
+    if (pages == PageSize::THP) {
+        //! the huge pages are only used for the aligned 2M ranges
+        m_ptr = allocate_aligned(HUGE_PAGE_SIZE, bytes);
+        megpeak_assert(m_ptr, "failed to allocate %zu bytes", bytes);
+        megpeak_assert(!madvise(m_ptr, bytes, MADV_HUGEPAGE),
+                       "madvise(MADV_HUGEPAGE) of %zu bytes failed, is the "
+                       "kernel built with transparent huge pages?",
+                       bytes);
+        return;
+    }
+    m_ptr = allocate_aligned(BASE_PAGE_SIZE, bytes);
+    megpeak_assert(m_ptr, "failed to allocate %zu bytes", bytes);
+    //! the kernel may back the buffer with transparent huge pages when they
+    //! are enabled always, a failure only means they are not built in
+    madvise(m_ptr, bytes, MADV_NOHUGEPAGE);
+#else
+    megpeak_assert(pages == PageSize::SMALL,
+                   "%s pages are only supported on linux",
+                   page_size_name(pages));
+    m_ptr = allocate_aligned(BASE_PAGE_SIZE, bytes);
+    megpeak_assert(m_ptr, "failed to allocate %zu bytes", bytes);
+#endif
+}
+
+Buffer::~Buffer() {
+#if defined(__linux__)
+    if (m_pages == PageSize::HUGETLB) {
+        munmap(m_ptr, m_mapped_size);
+        return;
+    }
+#endif
+#ifdef WIN32
+    _aligned_free(m_ptr);
+#else
+    free(m_ptr);
+#endif
+}
+
+double Buffer::huge_page_fraction() const {
+    if (m_pages == PageSize::HUGETLB) {
+        return 1;
+    }
+    if (m_pages == PageSize::SMALL) {
+        return 0;
+    }
+    FILE* file = fopen("/proc/self/smaps", "r");
+    if (!file) {
+        return 0;
+    }
+    uintptr_t first = reinterpret_cast<uintptr_t>(m_ptr),
+              last = first + m_size;
+    //! the AnonHugePages of the mappings which overlap the buffer, the
+    //! mapping of a buffer may be a little larger than it
+    size_t huge_bytes = 0;
+    bool overlap = false;
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        unsigned long start, end;
+        size_t kbytes;
+        //! a mapping starts with its address range, then its fields
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+            overlap = start < last && end > first;
+        } else if (overlap &&
+                   sscanf(line, "AnonHugePages: %zu kB", &kbytes) == 1) {
+            huge_bytes += kbytes * 1024;
+        }
+    }
+    fclose(file);
+    return std::min(1.0, static_cast<double>(huge_bytes) / m_size);
+}
+
+void Buffer::check_huge_pages() const {
+    if (m_pages != PageSize::THP) {
+        return;
+    }
+    double fraction = huge_page_fraction();
+    printf("%.0f%% of the %s thp buffer is backed by huge pages\n",
+           fraction * 100, format_size(m_size).c_str());
+    if (fraction < MIN_HUGE_PAGE_FRACTION) {
+        printf("WARNING: the kernel did not back the thp buffer with huge "
+               "pages, the thp results are mostly those of 4k pages, check "
+               "/sys/kernel/mm/transparent_hugepage/{enabled,defrag}\n");
+    }
+}
+
+bool megpeak::parse_size(const std::string& size, size_t& bytes) {
+    char* end = nullptr;
+    double value = strtod(size.c_str(), &end);
+    if (end == size.c_str() || !(value > 0) || std::isinf(value)) {
+        return false;
+    }
+    switch (*end) {
+        case 'g':
+        case 'G':
+            value *= 1024;
+            // fall through
+        case 'm':
+        case 'M':
+            value *= 1024;
+            // fall through
+        case 'k':
+        case 'K':
+            value *= 1024;
+            // fall through
+        case '\0':
+            break;
+        default:
+            return false;
+    }
+    if (*end != '\0' && end[1] != '\0') {
+        return false;
+    }
+    bytes = static_cast<size_t>(value);
+    return bytes > 0;
+}
+
+std::string megpeak::format_size(size_t bytes) {
+    const char* units[] = {"B", "KiB", "MiB", "GiB"};
+    double value = bytes;
+    size_t unit = 0;
+    while (value >= 1024 && unit + 1 < sizeof(units) / sizeof(units[0])) {
+        value /= 1024;
+        unit++;
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.4g %s", value, units[unit]);
+    return buf;
+}
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,100 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace megpeak {
+
+//! pages of the buffers of the memory benchmarks, see --pages
+enum class PageSize {
+    //! the base pages, transparent huge pages are disabled with madvise
+    SMALL,
+    //! transparent huge pages requested with madvise(MADV_HUGEPAGE)
+    THP,
+    //! huge pages of hugetlbfs, reserved in /proc/sys/vm/nr_hugepages
+    HUGETLB,
+};
+
+//! 4k, thp or hugetlb
+const char* page_size_name(PageSize pages);
+
+//! bytes of a page, the huge pages are taken as 2 MiB
+size_t page_bytes(PageSize pages);
+
+//! \return false if the name is not 4k, thp or hugetlb
+bool parse_page_size(const std::string& name, PageSize& pages);
+
+//! the page sizes of --pages, each memory benchmark is run with all of them
+std::vector<PageSize> get_page_sizes();
+
+/**
+ * the suite of the records of a memory benchmark, with the page size as a
+ * suffix, e.g. memory_thp, the base pages have no suffix
+ */
+std::string page_suite(const std::string& suite, PageSize pages);
+
+//! page aligned memory of the memory benchmarks, not touched on allocation
+class Buffer {
+public:
+    explicit Buffer(size_t bytes, PageSize pages = PageSize::SMALL);
+    ~Buffer();
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
+    template <typename T>
+    T* as() const {
+        return static_cast<T*>(m_ptr);
+    }
+    size_t size() const { return m_size; }
+
+    /**
+     * \brief the fraction of the buffer backed by huge pages, once touched
+     *
+     * madvise(MADV_HUGEPAGE) is only a hint, the thp buffers are checked
+     * with the AnonHugePages of their mappings in /proc/self/smaps. 1 for
+     * hugetlb, 0 for the base pages and without smaps
+     */
+    double huge_page_fraction() const;
+
+    /**
+     * \brief print the huge page fraction of a touched thp buffer, with a
+     * warning when the kernel did not back most of it with huge pages, the
+     * results are then those of the base pages
+     */
+    void check_huge_pages() const;
+
+private:
+    void* m_ptr = nullptr;
+    size_t m_size;
+    PageSize m_pages;
+    //! the size of the mapping of hugetlb, rounded up to the huge page
+    size_t m_mapped_size = 0;
+};
+
+/**
+ * \brief parse a size of memory in bytes
+ *
+ * \param size number with an optional K, M or G suffix of the powers of 1024,
+ *      e.g. 512K or 4G
+ * \return false if the size is not positive or anything follows the suffix
+ */
+bool parse_size(const std::string& size, size_t& bytes);
+
+//! the size in the largest unit of 1024 powers which keeps it above 1,
+//! e.g. 4 KiB, 1.5 MiB
+std::string format_size(size_t bytes);
+
+}  // namespace megpeak
+
+// vim: syntax=cpp.doxygen
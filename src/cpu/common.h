@@ -18,13 +18,19 @@
 #include <iostream>
 #include <stdlib.h>
 #include <string>
+#include <vector>
 
 #ifndef __APPLE__
 #include <malloc.h>
 #endif
 
 namespace megpeak {
-constexpr static uint32_t RUNS = 800000;
+/**
+ * a benchmark kernel runs its loop \p runs times and returns the number of
+ * the instructions under test it executed
+ */
+using KernelFunc = std::function<size_t(size_t runs)>;
+
 #define MEGPEAK_ATTRIBUTE_TARGET(simd) __attribute__((target(simd)))
 
 class Timer {
@@ -91,24 +97,83 @@ inline static float get_relative_diff(float lhs, float rhs) {
  *       dec 0r
  *       jne loop
  *
+ * each kernel is first warmed up until its speed is stable, see warm_up(),
+ * and the loop count is calibrated so that one run takes
+ * get_options().min_time_ms, see calibrate_runs(). Then each kernel is
+ * run get_options().nr_samples times, the median of the kept
+ * samples is reported together with the spread of the samples, see
+ * Statistics. With --format the results are also added to the result sink
+ * under the suite and the isa.
  */
-inline static void benchmark(std::function<int()> throughtput_func,
-                             std::function<int()> latency_func,
-                             const char* inst, size_t inst_simd = 4,
-                             std::string msg = "") {
-    Timer timer;
-    auto runs = throughtput_func();
-    float throuphput_used = timer.get_nsecs() / runs;
-    timer.reset();
-    runs = latency_func();
-    float latency_used = timer.get_nsecs() / runs;
-    printf("%s throughput: %f ns %f GFlops latency: %f ns :%s\n", inst,
-           throuphput_used, 1.f / throuphput_used * inst_simd, latency_used,
-           msg.c_str());
-}
+void benchmark(KernelFunc throughtput_func, KernelFunc latency_func,
+               const char* inst,
+               double inst_simd = 4, std::string msg = "",
+               const std::string& suite = "", const std::string& isa = "");
+
+/**
+ * \brief the loop count with which the kernel runs for at least
+ * get_options().min_time_ms
+ *
+ * the count is grown geometrically from 1, the last probe is very close to
+ * the target time, so the probes also warm up the core a bit.
+ */
+size_t calibrate_runs(const KernelFunc& func);
+
+//! the loop count with which the kernel runs for at least \p time_ms
+size_t calibrate_runs(const KernelFunc& func, double time_ms);
+
+struct WarmupResult {
+    //! time spent in the warm-up, including the calibration of the probes
+    double time_ms = 0;
+    size_t nr_probes = 0;
+    //! false if get_options().max_warmup_ms elapsed before it was stable
+    bool converged = true;
+};
+
+/**
+ * \brief run short probes of the kernel until its speed is stable
+ *
+ * the dvfs governor of phones ramps up the frequency slowly and the avx512
+ * license of x86 changes the frequency after the first wide instructions,
+ * so the first kernel measured on a cold core is too slow. The kernel is
+ * run in probes of a tenth of get_options().min_time_ms until the speed of
+ * three successive probes differs by less than
+ * get_options().warmup_tolerance from the previous one, or
+ * get_options().max_warmup_ms elapsed.
+ */
+WarmupResult warm_up(const KernelFunc& func);
 
+/**
+ * \brief core cycles per instruction of the kernel, without printing
+ *
+ * the kernel is warmed up, calibrated and sampled like in benchmark(), the
+ * median is returned. When the cycle counter does not count core cycles the
+ * ns are converted with the frequency measured once by measure_frequency().
+ */
+double measure_cycles(const KernelFunc& func);
+
+/**
+ * \brief throughput of an instruction with 1 ... N independent chains
+ *
+ * \param chains the kernel with i + 1 independent dependency chains at
+ *      index i, see ILP_SWEEP. The sweep stops at get_options().ilp_chains
+ *
+ * prints the throughput curve and the number of chains from which the
+ * throughput is within 5% of the best one, that is how many accumulators a
+ * kernel needs to saturate the pipes of the instruction.
+ */
+void ilp_sweep(const std::vector<KernelFunc>& chains, const char* inst,
+               size_t inst_simd, const std::string& suite,
+               const std::string& isa);
+
+#define UNROLL_RAW1(cb, v0, a...) cb(0, ##a)
+#define UNROLL_RAW2(cb, v0, a...) UNROLL_RAW1(cb, v0, ##a) cb(1, ##a)
+#define UNROLL_RAW3(cb, v0, a...) UNROLL_RAW2(cb, v0, ##a) cb(2, ##a)
+#define UNROLL_RAW4(cb, v0, a...) UNROLL_RAW3(cb, v0, ##a) cb(3, ##a)
 #define UNROLL_RAW5(cb, v0, a...) \
     cb(0, ##a) cb(1, ##a) cb(2, ##a) cb(3, ##a) cb(4, ##a)
+#define UNROLL_RAW6(cb, v0, a...) UNROLL_RAW5(cb, v0, ##a) cb(5, ##a)
+#define UNROLL_RAW7(cb, v0, a...) UNROLL_RAW6(cb, v0, ##a) cb(6, ##a)
 
 #define UNROLL_RAW8(cb, v0, a...) \
     UNROLL_RAW5(cb, v0, ##a)      \
@@ -121,9 +186,14 @@ inline static void benchmark(std::function<int()> throughtput_func,
 #define UNROLL_RAW10(cb, v0, a...) \
     UNROLL_RAW5(cb, v0, ##a)       \
     cb(5, ##a) cb(6, ##a) cb(7, ##a) cb(8, ##a) cb(9, ##a)
+#define UNROLL_RAW11(cb, v0, a...) UNROLL_RAW10(cb, v0, ##a) cb(10, ##a)
+#define UNROLL_RAW12(cb, v0, a...) UNROLL_RAW11(cb, v0, ##a) cb(11, ##a)
+#define UNROLL_RAW13(cb, v0, a...) UNROLL_RAW12(cb, v0, ##a) cb(12, ##a)
+#define UNROLL_RAW14(cb, v0, a...) UNROLL_RAW13(cb, v0, ##a) cb(13, ##a)
 #define UNROLL_RAW15(cb, v0, a...) \
     UNROLL_RAW10(cb, v0, ##a)      \
     cb(10, ##a) cb(11, ##a) cb(12, ##a) cb(13, ##a) cb(14, ##a)
+#define UNROLL_RAW16(cb, v0, a...) UNROLL_RAW15(cb, v0, ##a) cb(15, ##a)
 #define UNROLL_RAW20(cb, v0, a...)                                          \
     UNROLL_RAW10(cb, v0, ##a)                                               \
     cb(10, ##a) cb(11, ##a) cb(12, ##a) cb(13, ##a) cb(14, ##a) cb(15, ##a) \
@@ -148,6 +218,37 @@ inline static void benchmark(std::function<int()> throughtput_func,
     UNROLL_RAW##step##_START6(cb, 0, ##v)
 #define UNROLL_CALL_START6(step, cb, v...) UNROLL_CALL0_START6(step, cb, ##v)
 
+//! the largest number of independent chains of the ilp sweep
+#define MAX_ILP_CHAINS 16
+//! the instructions of each chain in one loop iteration of the ilp kernels
+#define ILP_CHAIN_LENGTH 4
+
+/**
+ * define the func##_chains1 ... func##_chains16 kernels of the ilp sweep with
+ * the ILP(cb, func, chains, ...) macro of the architecture. The kernel with
+ * n chains runs cb(0) ... cb(n - 1) ILP_CHAIN_LENGTH times per iteration,
+ * cb(i) must only depend on the register i, like the throughput kernels.
+ */
+#define ILP_SWEEP(cb, func, a...)                                      \
+    ILP(cb, func, 1, ##a) ILP(cb, func, 2, ##a) ILP(cb, func, 3, ##a)  \
+    ILP(cb, func, 4, ##a) ILP(cb, func, 5, ##a) ILP(cb, func, 6, ##a)  \
+    ILP(cb, func, 7, ##a) ILP(cb, func, 8, ##a) ILP(cb, func, 9, ##a)  \
+    ILP(cb, func, 10, ##a) ILP(cb, func, 11, ##a)                      \
+    ILP(cb, func, 12, ##a) ILP(cb, func, 13, ##a)                      \
+    ILP(cb, func, 14, ##a) ILP(cb, func, 15, ##a)                      \
+    ILP(cb, func, 16, ##a)
+
+#define ILP_BODY(chains, cb)                                           \
+    UNROLL_CALL(chains, cb) UNROLL_CALL(chains, cb)                    \
+    UNROLL_CALL(chains, cb) UNROLL_CALL(chains, cb)
+
+//! the kernels defined by ILP_SWEEP, ordered by the number of chains
+#define ILP_CHAINS(func)                                                   \
+    {func##_chains1,  func##_chains2,  func##_chains3,  func##_chains4,    \
+     func##_chains5,  func##_chains6,  func##_chains7,  func##_chains8,    \
+     func##_chains9,  func##_chains10, func##_chains11, func##_chains12,   \
+     func##_chains13, func##_chains14, func##_chains15, func##_chains16}
+
 // dec to bin
 #define _DEC_BIN_0 "00000"
 #define _DEC_BIN_1 "00001"
@@ -212,12 +313,13 @@ void loongarch_lasx();
 }  // namespace megpeak
 namespace {
 /**
- * @brief Get the mem align64 object, only for single thread
+ * @brief Get the mem align64 object, each thread has its own buffer, so the
+ * kernels run on several cores do not share the cache lines
  *
  * @return void*
  */
 static inline void* get_mem_align64() {
-    static void* mem_algn64 = nullptr;
+    static thread_local void* mem_algn64 = nullptr;
     size_t alignment = 64;
     size_t size = 2048;
     if (mem_algn64 == nullptr) {
@@ -0,0 +1,133 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/cpu/cycle_counter.h"
+
+#include <stdio.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#define MEGPEAK_PERF_CPU_CYCLES PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES
+#else
+#define MEGPEAK_PERF_CPU_CYCLES 0, 0
+#endif
+
+using namespace megpeak;
+
+namespace {
+#if MEGPEAK_X86
+constexpr bool HAS_ARCH_COUNTER = true;
+//! lfence keeps the earlier instructions from leaking into the measurement
+inline uint64_t arch_counter_begin() {
+    uint32_t lo, hi;
+    asm volatile("lfence\n"
+                 "rdtsc\n"
+                 : "=a"(lo), "=d"(hi)
+                 :
+                 : "memory");
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+//! rdtscp waits for all the earlier instructions to finish
+inline uint64_t arch_counter_end() {
+    uint32_t lo, hi;
+    asm volatile("rdtscp\n"
+                 "lfence\n"
+                 : "=a"(lo), "=d"(hi)
+                 :
+                 : "rcx", "memory");
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+std::string arch_counter_name() {
+    return "rdtsc (reference cycles)";
+}
+#elif MEGPEAK_AARCH64
+constexpr bool HAS_ARCH_COUNTER = true;
+inline uint64_t arch_counter_begin() {
+    uint64_t val;
+    asm volatile("isb\n"
+                 "mrs %0, cntvct_el0\n"
+                 : "=r"(val)
+                 :
+                 : "memory");
+    return val;
+}
+inline uint64_t arch_counter_end() {
+    return arch_counter_begin();
+}
+std::string arch_counter_name() {
+    uint64_t freq;
+    asm volatile("mrs %0, cntfrq_el0\n" : "=r"(freq));
+    char buf[64];
+    snprintf(buf, sizeof(buf), "cntvct_el0 (%.1f MHz ticks)", freq / 1e6);
+    return buf;
+}
+#elif MEGPEAK_LOONGARCH
+constexpr bool HAS_ARCH_COUNTER = true;
+inline uint64_t arch_counter_begin() {
+    uint64_t val;
+    asm volatile("rdtime.d %0, $zero\n" : "=r"(val) : : "memory");
+    return val;
+}
+inline uint64_t arch_counter_end() {
+    return arch_counter_begin();
+}
+std::string arch_counter_name() {
+    return "rdtime.d (stable counter ticks)";
+}
+#else
+constexpr bool HAS_ARCH_COUNTER = false;
+inline uint64_t arch_counter_begin() {
+    return 0;
+}
+inline uint64_t arch_counter_end() {
+    return 0;
+}
+std::string arch_counter_name() {
+    return "none";
+}
+#endif
+}  // namespace
+
+CycleCounter::CycleCounter() : m_perf{MEGPEAK_PERF_CPU_CYCLES} {
+    if (m_perf.valid()) {
+        m_source = Source::PERF;
+        m_name = "perf cpu-cycles";
+    } else if (HAS_ARCH_COUNTER) {
+        m_source = Source::ARCH;
+        m_name = arch_counter_name();
+    } else {
+        m_name = "none";
+    }
+}
+
+void CycleCounter::start() {
+    if (m_source == Source::PERF) {
+        m_perf.start();
+    } else if (m_source == Source::ARCH) {
+        m_start = arch_counter_begin();
+    }
+}
+
+uint64_t CycleCounter::stop() {
+    if (m_source == Source::PERF) {
+        return m_perf.stop();
+    } else if (m_source == Source::ARCH) {
+        return arch_counter_end() - m_start;
+    }
+    return 0;
+}
+
+CycleCounter& megpeak::get_cycle_counter() {
+    static thread_local CycleCounter counter;
+    return counter;
+}
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,56 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "src/cpu/perf_event.h"
+
+namespace megpeak {
+
+/**
+ * \brief count the cycles spent by the calling thread
+ *
+ * PERF_COUNT_HW_CPU_CYCLES is preferred as it counts the real core clock.
+ * When perf is not usable the architecture counter is used instead:
+ * rdtsc/rdtscp on x86, cntvct_el0 on aarch64 and rdtime on loongarch, these
+ * tick at a constant rate which is not the core clock, see is_core_clock().
+ * armv7 has no user space counter, so only perf is available there.
+ */
+class CycleCounter {
+public:
+    CycleCounter();
+
+    bool valid() const { return m_source != Source::NONE; }
+    //! whether the counter ticks with the core clock
+    bool is_core_clock() const { return m_source == Source::PERF; }
+    const std::string& name() const { return m_name; }
+
+    void start();
+    //! return the number of cycles since start()
+    uint64_t stop();
+
+private:
+    enum class Source { NONE, PERF, ARCH };
+
+    PerfEvent m_perf;
+    Source m_source = Source::NONE;
+    std::string m_name;
+    uint64_t m_start = 0;
+};
+
+//! the cycle counter of the calling thread
+CycleCounter& get_cycle_counter();
+
+}  // namespace megpeak
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,106 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/cpu/frequency.h"
+
+#include <vector>
+
+#include "src/cpu/common.h"
+#include "src/statistics.h"
+
+using namespace megpeak;
+
+namespace {
+//! number of dependent adds in one loop iteration
+constexpr size_t NR_ADDS = 40;
+constexpr size_t NR_SAMPLES = 5;
+//! the time of a single sample
+constexpr double SAMPLE_NSECS = 10 * 1e6;
+
+// clang-format off
+#if MEGPEAK_X86
+#define cb(i) "add %[one], %[acc]\n"
+#define LOOP_TAIL             \
+    "sub $1, %[runs]\n"       \
+    "jne 1b\n"
+#elif MEGPEAK_AARCH64
+#define cb(i) "add %x[acc], %x[acc], %x[one]\n"
+#define LOOP_TAIL                       \
+    "subs %x[runs], %x[runs], #1\n"     \
+    "bne 1b\n"
+#elif MEGPEAK_ARMV7
+#define cb(i) "add %[acc], %[acc], %[one]\n"
+#define LOOP_TAIL                   \
+    "subs %[runs], %[runs], #1\n"   \
+    "bne 1b\n"
+#elif MEGPEAK_LOONGARCH
+#define cb(i) "add.d %[acc], %[acc], %[one]\n"
+#define LOOP_TAIL                       \
+    "addi.d %[runs], %[runs], -1\n"     \
+    "bnez %[runs], 1b\n"
+#endif
+
+#ifdef LOOP_TAIL
+constexpr bool HAS_PROBE = true;
+size_t add_chain(size_t runs) {
+    size_t acc = 0, one = 1;
+    asm volatile(
+        "1:\n"
+        UNROLL_CALL(20, cb)
+        UNROLL_CALL(20, cb)
+        LOOP_TAIL
+        : [acc] "+r"(acc), [runs] "+r"(runs)
+        : [one] "r"(one)
+        : "cc");
+    return acc;
+}
+#undef cb
+#undef LOOP_TAIL
+#else
+//! the compiler can not be trusted to keep the chain, no probe here
+constexpr bool HAS_PROBE = false;
+size_t add_chain(size_t) {
+    return 0;
+}
+#endif
+// clang-format on
+}  // namespace
+
+double megpeak::measure_frequency() {
+    if (!HAS_PROBE) {
+        return 0;
+    }
+    //! calibrate the iteration count to about 1 ms
+    size_t runs = 1024;
+    double used = 0;
+    for (;;) {
+        Timer timer;
+        add_chain(runs);
+        used = timer.get_nsecs();
+        if (used > 1e6) {
+            break;
+        }
+        runs *= 2;
+    }
+    runs = std::max<size_t>(runs * (SAMPLE_NSECS / used), 1);
+
+    std::vector<double> samples;
+    for (size_t i = 0; i < NR_SAMPLES; i++) {
+        Timer timer;
+        if (add_chain(runs) != runs * NR_ADDS) {
+            return 0;
+        }
+        samples.push_back(runs * NR_ADDS / timer.get_nsecs() * 1e3);
+    }
+    return compute_statistics(samples).median;
+}
+
+// vim: syntax=cpp.doxygen
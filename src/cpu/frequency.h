@@ -0,0 +1,29 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+#pragma once
+
+namespace megpeak {
+
+/**
+ * \brief measure the effective frequency of the current core in MHz
+ *
+ * a dependent chain of register-register integer adds retires exactly one
+ * add per cycle on all the supported cores, so the number of adds done per ns
+ * is the frequency. Adds with an immediate are not used, as some x86 cores
+ * fold them at rename and retire several of them per cycle.
+ * The probe runs for a few tens of ms, the median of several samples is
+ * returned.
+ */
+double measure_frequency();
+
+}  // namespace megpeak
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,251 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/cpu/jit.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <memory>
+#include <sstream>
+
+#include "src/backend.h"
+#include "src/cpu/common.h"
+#include "src/options.h"
+#include "src/report.h"
+
+using namespace megpeak;
+
+namespace {
+//! the ratio sweep goes from 1:MAX_RATIO to MAX_RATIO:1
+constexpr size_t MAX_RATIO = 8;
+//! relative loss of throughput an instruction tolerates in the ratio sweep
+constexpr double RATIO_TOLERANCE = 0.05;
+
+//! counts[i] copies of insts[i], spread evenly over the mix
+std::vector<MixInst> interleave(const std::vector<MixInst>& insts,
+                                const std::vector<size_t>& counts) {
+    size_t total = 0;
+    for (auto count : counts) {
+        total += count;
+    }
+    std::vector<size_t> placed(counts.size(), 0);
+    std::vector<MixInst> ret;
+    for (size_t slot = 0; slot < total; slot++) {
+        //! the instruction which is the most behind its share
+        size_t best = 0;
+        double best_deficit = -1;
+        for (size_t i = 0; i < counts.size(); i++) {
+            double deficit = static_cast<double>(counts[i]) * (slot + 1) /
+                                     total -
+                             placed[i];
+            if (placed[i] < counts[i] && deficit > best_deficit) {
+                best = i;
+                best_deficit = deficit;
+            }
+        }
+        placed[best]++;
+        ret.push_back(insts[best]);
+    }
+    return ret;
+}
+
+std::string ratio_name(const std::vector<size_t>& counts) {
+    std::string ret;
+    for (auto count : counts) {
+        ret += (ret.empty() ? "" : ":") + std::to_string(count);
+    }
+    return ret;
+}
+}  // namespace
+
+std::vector<MixInst> megpeak::parse_mix(const std::string& mix) {
+    std::vector<MixInst> ret;
+    std::stringstream insts(mix);
+    std::string text;
+    while (std::getline(insts, text, ';')) {
+        for (auto&& c : text) {
+            c = c == ',' ? ' ' : c;
+        }
+        std::stringstream tokens(text);
+        MixInst inst;
+        std::string token;
+        while (tokens >> token) {
+            if (inst.mnemonic.empty()) {
+                inst.mnemonic = token;
+            } else {
+                inst.operands.push_back(token);
+            }
+            inst.text += (inst.text.empty() ? "" : " ") + token;
+        }
+        if (!inst.mnemonic.empty()) {
+            ret.emplace_back(std::move(inst));
+        }
+    }
+    megpeak_assert(!ret.empty(), "no instruction in the mix \"%s\"",
+                   mix.c_str());
+    return ret;
+}
+
+JitCode::JitCode(const std::vector<uint8_t>& code) : m_size(code.size()) {
+    m_ptr = mmap(nullptr, m_size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    megpeak_assert(m_ptr != MAP_FAILED, "mmap of %zu bytes failed: %s",
+                   m_size, strerror(errno));
+    memcpy(m_ptr, code.data(), m_size);
+    char* begin = static_cast<char*>(m_ptr);
+    __builtin___clear_cache(begin, begin + m_size);
+    megpeak_assert(mprotect(m_ptr, m_size, PROT_READ | PROT_EXEC) == 0,
+                   "can not make the jit code executable: %s",
+                   strerror(errno));
+}
+
+JitCode::~JitCode() {
+    munmap(m_ptr, m_size);
+}
+
+void JitCode::operator()(size_t runs, void* mem) const {
+    using Func = void (*)(size_t, void*);
+    reinterpret_cast<Func>(m_ptr)(runs, mem);
+}
+
+#if !MEGPEAK_JIT
+MixCode megpeak::assemble_mix(const std::vector<MixInst>&) {
+    megpeak_assert(false, "%s", "--mix is not supported on this architecture");
+    return {};
+}
+#endif
+
+void megpeak::run_mix(const std::string& mix) {
+    auto insts = parse_mix(mix);
+    std::string name;
+    for (auto&& inst : insts) {
+        name += (name.empty() ? "" : "; ") + inst.text;
+    }
+    auto code = assemble_mix(insts);
+    auto&& dump = get_options().mix_dump;
+    if (!dump.empty()) {
+        FILE* file = fopen(dump.c_str(), "wb");
+        megpeak_assert(file, "can not open %s: %s", dump.c_str(),
+                       strerror(errno));
+        fwrite(code.throughput.data(), 1, code.throughput.size(), file);
+        fclose(file);
+    }
+    auto throughput = std::make_shared<JitCode>(code.throughput);
+    auto latency = std::make_shared<JitCode>(code.latency);
+    //! the results are per instruction, like the other kernels
+    size_t nr_insts = code.nr_passes * insts.size();
+    void* mem = get_mem_align64();
+    benchmark(
+            [=](size_t runs) {
+                (*throughput)(runs, mem);
+                return runs * nr_insts;
+            },
+            [=](size_t runs) {
+                (*latency)(runs, mem);
+                return runs * nr_insts;
+            },
+            name.c_str(), static_cast<double>(code.flops) / insts.size(),
+            "", "mix", code.isa);
+}
+
+double megpeak::mix_cycles(const std::vector<MixInst>& mix) {
+    auto code = assemble_mix(mix);
+    auto loop = std::make_shared<JitCode>(code.throughput);
+    size_t nr_passes = code.nr_passes;
+    void* mem = get_mem_align64();
+    return measure_cycles([=](size_t runs) {
+        (*loop)(runs, mem);
+        return runs * nr_passes;
+    });
+}
+
+void megpeak::ratio_sweep(const std::string& mix) {
+    auto insts = parse_mix(mix);
+    size_t nr_insts = insts.size();
+    megpeak_assert(nr_insts == 2 || nr_insts == 3,
+                   "the ratio sweep needs 2 or 3 instructions, got %zu",
+                   nr_insts);
+    std::string names;
+    for (auto&& inst : insts) {
+        names += (names.empty() ? "" : " : ") + inst.text;
+    }
+    printf("ratio sweep of %s:\n", names.c_str());
+    std::vector<double> alone;
+    for (auto&& inst : insts) {
+        alone.push_back(1 / mix_cycles({inst}));
+        printf("    %s alone: %f inst/cycle\n", inst.text.c_str(),
+               alone.back());
+    }
+
+    //! from the fewest to the most of the first instruction
+    std::vector<std::vector<size_t>> points;
+    for (size_t i = MAX_RATIO; i > 1; i--) {
+        points.push_back(std::vector<size_t>(nr_insts, i));
+        points.back()[0] = 1;
+    }
+    for (size_t i = 1; i <= MAX_RATIO; i++) {
+        points.push_back(std::vector<size_t>(nr_insts, 1));
+        points.back()[0] = i;
+    }
+    //! rates[p][i] is the throughput of instruction i at point p
+    std::vector<std::vector<double>> rates;
+    size_t best = 0;
+    double best_total = 0;
+    for (auto&& counts : points) {
+        double cycles = mix_cycles(interleave(insts, counts));
+        double total = 0;
+        rates.emplace_back();
+        auto name = ratio_name(counts);
+        printf("    %-7s", name.c_str());
+        for (size_t i = 0; i < nr_insts; i++) {
+            double rate = counts[i] / cycles;
+            total += rate;
+            rates.back().push_back(rate);
+            printf(" %f(%3.0f%%)", rate, rate / alone[i] * 100);
+        }
+        printf(" total %f inst/cycle\n", total);
+        report_result("ratio", names + " " + name, "", "throughput",
+                      "inst/cycle", total);
+        if (total > best_total) {
+            best = rates.size() - 1;
+            best_total = total;
+        }
+    }
+    printf("    best total %f inst/cycle at %s\n", best_total,
+           ratio_name(points[best]).c_str());
+    //! the first instruction loses its share towards the start of the
+    //! sweep, the others towards the end
+    for (size_t i = 0; i < nr_insts; i++) {
+        std::vector<size_t> order(points.size());
+        for (size_t p = 0; p < order.size(); p++) {
+            order[p] = i ? p : order.size() - 1 - p;
+        }
+        size_t last = order.size();
+        for (auto p : order) {
+            if (rates[p][i] < alone[i] * (1 - RATIO_TOLERANCE)) {
+                break;
+            }
+            last = p;
+        }
+        if (last == order.size()) {
+            printf("    %s is below its peak at every ratio\n",
+                   insts[i].text.c_str());
+        } else {
+            printf("    %s keeps its peak up to %s\n", insts[i].text.c_str(),
+                   ratio_name(points[last]).c_str());
+        }
+    }
+}
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,104 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if (MEGPEAK_X86 && defined(__x86_64__)) || MEGPEAK_AARCH64
+#define MEGPEAK_JIT 1
+#else
+#define MEGPEAK_JIT 0
+#endif
+
+namespace megpeak {
+
+//! one instruction of a --mix, e.g. "vfmadd231ps ymm", "vmovups load" or
+//! "fmla 4s"
+struct MixInst {
+    std::string text;
+    std::string mnemonic;
+    //! register class or memory access of the operands, e.g. ymm, load
+    std::vector<std::string> operands;
+};
+
+//! split a mix like "vfmadd231ps ymm; vpaddd ymm; vmovups load"
+std::vector<MixInst> parse_mix(const std::string& mix);
+
+//! machine code of the loops of a mix, see assemble_mix()
+struct MixCode {
+    //! each instruction on its own register, the registers are allocated
+    //! round robin so that there is no false dependency between them
+    std::vector<uint8_t> throughput;
+    //! all the instructions on the same register, a single dependency chain
+    std::vector<uint8_t> latency;
+    //! passes over the mix in one loop iteration
+    size_t nr_passes = 0;
+    //! operations done by one pass over the mix, used to compute the GFlops
+    size_t flops = 0;
+    //! comma separated isa extensions used by the mix
+    std::string isa;
+};
+
+/**
+ * \brief encode the loops of a mix for the current architecture
+ *
+ * the loops have the signature void (size_t runs, void* mem), each loop
+ * iteration runs the mix MixCode::nr_passes times, memory operands access
+ * the 64 bytes aligned buffer mem of at least 2048 bytes. Unknown
+ * instructions and unsupported isa are fatal errors.
+ */
+MixCode assemble_mix(const std::vector<MixInst>& mix);
+
+/**
+ * \brief machine code in an executable mapping
+ *
+ * the code is copied to a private anonymous mapping, which is made
+ * executable and no more writable before it is called.
+ */
+class JitCode {
+public:
+    explicit JitCode(const std::vector<uint8_t>& code);
+    ~JitCode();
+    JitCode(const JitCode&) = delete;
+    JitCode& operator=(const JitCode&) = delete;
+
+    void operator()(size_t runs, void* mem) const;
+
+private:
+    void* m_ptr = nullptr;
+    size_t m_size = 0;
+};
+
+//! assemble the mix and benchmark its throughput and latency per instruction
+void run_mix(const std::string& mix);
+
+//! core cycles of one pass over the throughput loop of the mix, see
+//! measure_cycles()
+double mix_cycles(const std::vector<MixInst>& mix);
+
+/**
+ * \brief throughput of 2 or 3 instructions over their interleave ratios
+ *
+ * the first instruction is swept against the others from 1:8 to 8:1, the
+ * others stay 1:1 among themselves, e.g. "ldr q; fmla lane" runs 1 load per
+ * 8 fmla up to 8 loads per fmla. Each point is spread evenly in the loop.
+ * Prints the total throughput and the one of each instruction against its
+ * throughput alone, and for each instruction the largest share of the
+ * others it tolerates within 5% of its own peak.
+ */
+void ratio_sweep(const std::string& mix);
+
+}  // namespace megpeak
+
+// vim: syntax=cpp.doxygen
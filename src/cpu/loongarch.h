@@ -18,67 +18,85 @@
 #define eor(i) "xvxor.v $xr" #i ", $xr" #i ", $xr" #i "\n"
 // clang-format off
 #define THROUGHPUT(cb, func)                                  \
-    static int func##_throughput() {                          \
+    static size_t func##_throughput(size_t runs) {            \
+        size_t run_times = runs;                              \
         asm volatile(                                         \
         UNROLL_CALL(10, eor)                                  \
         "1:\n"                                                \
         UNROLL_CALL(10, cb)                                   \
         "addi.d  %[RUNS],   %[RUNS],    -1\n"                 \
         "bnez    %[RUNS],   1b\n"                             \
+        :[RUNS]"+r"(run_times)                                \
         :                                                     \
-        :[RUNS]"r"(megpeak::RUNS * 100)                       \
         :                                                     \
         );                                                    \
-        return megpeak::RUNS * 100 * 10;                      \
+        return runs * 10;                                     \
     }
 
 #define LATENCY(cb, func)                                  \
-    static int func##_latency() {                          \
+    static size_t func##_latency(size_t runs) {            \
+        size_t run_times = runs;                           \
         asm volatile(                                      \
         "xvxor.v $xr0, $xr0, $xr0 \n"                      \
         "1:\n"                                             \
         UNROLL_CALL(10, cb)                                \
         "addi.d  %[RUNS],   %[RUNS],    -1\n"              \
         "bnez    %[RUNS],   1b\n"                          \
+        :[RUNS]"+r"(run_times)                             \
         :                                                  \
-        :[RUNS]"r"(megpeak::RUNS * 100)                    \
         :                                                  \
         );                                                 \
-        return megpeak::RUNS * 100 * 10;                   \
+        return runs * 10;                                  \
+    }
+
+#define ILP(cb, func, chains)                                 \
+    static size_t func##_chains##chains(size_t runs) {        \
+        size_t run_times = runs;                              \
+        asm volatile(                                         \
+        UNROLL_CALL(chains, eor)                              \
+        "1:\n"                                                \
+        ILP_BODY(chains, cb)                                  \
+        "addi.d  %[RUNS],   %[RUNS],    -1\n"                 \
+        "bnez    %[RUNS],   1b\n"                             \
+        :[RUNS]"+r"(run_times)                                \
+        :                                                     \
+        :                                                     \
+        );                                                    \
+        return runs * chains * ILP_CHAIN_LENGTH;              \
     }
 
 #define THROUGHPUT_MEM(cb, func)                                            \
-    static int func##_throughput() {                                        \
+    static size_t func##_throughput(size_t runs) {                          \
         const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());   \
-        const size_t run_times = megpeak::RUNS;                             \
+        size_t run_times = runs;                                            \
         asm volatile(                                                       \
         UNROLL_CALL(20, eor)                                                \
         "1:\n"                                                              \
         UNROLL_CALL(20, cb)                                                 \
         "addi.d %[RUNS],    %[RUNS],    -1 \n"                              \
         "bnez   %[RUNS],    1b \n"                                          \
-        :                                                                   \
-        : [RUNS]"r"(run_times), [a_ptr]"r"(a_ptr)                           \
+        : [RUNS]"+r"(run_times)                                             \
+        : [a_ptr]"r"(a_ptr)                                                 \
         : "memory"                                                          \
         );                                                                  \
-        return megpeak::RUNS * 20;                                          \
+        return runs * 20;                                                   \
     }
 
 #define LATENCY_MEM(cb, func)                                               \
-    static int func##_latency() {                                           \
+    static size_t func##_latency(size_t runs) {                             \
         const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());   \
-        const size_t run_times = megpeak::RUNS;                             \
+        size_t run_times = runs;                                            \
         asm volatile(                                                       \
         "xvxor.v $xr0, $xr0, $xr0 \n"                                       \
         "1:\n"                                                              \
         UNROLL_CALL(20, cb)                                                 \
         "addi.d %[RUNS],    %[RUNS],    -1 \n"                              \
         "bnez   %[RUNS],    1b \n"                                          \
-        :                                                                   \
-        : [RUNS]"r"(run_times), [a_ptr]"r"(a_ptr)                           \
+        : [RUNS]"+r"(run_times)                                             \
+        : [a_ptr]"r"(a_ptr)                                                 \
         : "memory"                                                          \
         );                                                                  \
-        return megpeak::RUNS * 20;                                          \
+        return runs * 20;                                                   \
     }
 
 // Vector memory access instructions
@@ -225,6 +243,7 @@ LATENCY(cb, xvfdiv_d)
 
 #define cb(i) "xvfmadd.s    $xr" #i ",   $xr" #i ",  $xr" #i ",  $xr" #i " \n"
 THROUGHPUT(cb, xvfmadd_s)
+ILP_SWEEP(cb, xvfmadd_s)
 #undef cb
 #define cb(i) "xvfmadd.s    $xr0,   $xr0,   $xr0,   $xr0 \n"
 LATENCY(cb, xvfmadd_s)
@@ -232,6 +251,7 @@ LATENCY(cb, xvfmadd_s)
 
 #define cb(i) "xvfmadd.d    $xr" #i ",   $xr" #i ",  $xr" #i ",  $xr" #i " \n"
 THROUGHPUT(cb, xvfmadd_d)
+ILP_SWEEP(cb, xvfmadd_d)
 #undef cb
 #define cb(i) "xvfmadd.d    $xr0,   $xr0,   $xr0,   $xr0 \n"
 LATENCY(cb, xvfmadd_d)
@@ -0,0 +1,96 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/cpu/loop_overhead.h"
+
+#include <stdint.h>
+#include <vector>
+
+#include "src/cpu/common.h"
+#include "src/cpu/cycle_counter.h"
+#include "src/options.h"
+#include "src/statistics.h"
+
+using namespace megpeak;
+
+namespace {
+// clang-format off
+#if MEGPEAK_X86
+#define LOOP_TAIL             \
+    "sub $1, %[runs]\n"       \
+    "jne 1b\n"
+#elif MEGPEAK_AARCH64
+#define LOOP_TAIL                       \
+    "subs %x[runs], %x[runs], #1\n"     \
+    "bne 1b\n"
+#elif MEGPEAK_ARMV7
+#define LOOP_TAIL                   \
+    "subs %[runs], %[runs], #1\n"   \
+    "bne 1b\n"
+#elif MEGPEAK_LOONGARCH
+#define LOOP_TAIL                       \
+    "addi.d %[runs], %[runs], -1\n"     \
+    "bnez %[runs], 1b\n"
+#endif
+
+#ifdef LOOP_TAIL
+constexpr bool HAS_EMPTY_LOOP = true;
+size_t empty_loop(size_t runs) {
+    size_t run_times = runs;
+    asm volatile(
+        "1:\n"
+        LOOP_TAIL
+        : [runs] "+r"(run_times)
+        :
+        : "cc");
+    return runs;
+}
+#undef LOOP_TAIL
+#else
+constexpr bool HAS_EMPTY_LOOP = false;
+size_t empty_loop(size_t runs) {
+    return runs;
+}
+#endif
+// clang-format on
+
+LoopOverhead measure_loop_overhead() {
+    LoopOverhead ret;
+    if (!HAS_EMPTY_LOOP) {
+        return ret;
+    }
+    warm_up(empty_loop);
+    size_t nr_runs = calibrate_runs(empty_loop);
+    size_t nr_samples = std::max<size_t>(get_options().nr_samples, 1);
+    auto& counter = get_cycle_counter();
+    std::vector<double> nsecs, cycles;
+    for (size_t i = 0; i < nr_samples; i++) {
+        Timer timer;
+        counter.start();
+        empty_loop(nr_runs);
+        uint64_t used_cycles = counter.stop();
+        nsecs.push_back(timer.get_nsecs() / nr_runs);
+        cycles.push_back(static_cast<double>(used_cycles) / nr_runs);
+    }
+    ret.nsecs = compute_statistics(nsecs).median;
+    if (counter.valid()) {
+        ret.cycles = compute_statistics(cycles).median;
+    }
+    return ret;
+}
+}  // namespace
+
+const LoopOverhead& megpeak::get_loop_overhead() {
+    static LoopOverhead overhead = measure_loop_overhead();
+    return overhead;
+}
+
+// vim: syntax=cpp.doxygen
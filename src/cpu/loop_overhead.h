@@ -0,0 +1,41 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+#pragma once
+
+namespace megpeak {
+
+//! cost of one iteration of a loop without body
+struct LoopOverhead {
+    double nsecs = 0;
+    //! in the unit of the cycle counter, 0 if it is not valid
+    double cycles = 0;
+};
+
+/**
+ * \brief the cost of the loop tail shared by all the kernels
+ *
+ * every kernel ends its loop with a counter decrement and a conditional
+ * branch, sub/jne on x86, subs/bne on arm and addi.d/bnez on loongarch, which
+ * is counted against the instructions under test. The loop is measured once
+ * with an empty body, a kernel which runs unroll instructions per iteration
+ * pays 1/unroll of it per instruction.
+ *
+ * On out of order cores the tail mostly issues in parallel with the body, so
+ * the cost is an upper bound of the bias, on in order cores it is exact. It
+ * is only printed, subtracting it gives impossible rates on out of order
+ * cores.
+ * Both members are 0 if the architecture has no empty loop kernel.
+ */
+const LoopOverhead& get_loop_overhead();
+
+}  // namespace megpeak
+
+// vim: syntax=cpp.doxygen
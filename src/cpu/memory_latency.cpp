@@ -0,0 +1,343 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/cpu/memory_latency.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "src/cpu/buffer.h"
+#include "src/cpu/common.h"
+#include "src/cpu/frequency.h"
+#include "src/options.h"
+#include "src/report.h"
+#include "src/statistics.h"
+
+using namespace megpeak;
+
+namespace {
+constexpr size_t CACHE_LINE = 64;
+//! smallest working set of the sweep
+constexpr size_t MIN_BYTES = 4 * 1024;
+//! the working set grows by 2^(1/2) per step
+constexpr size_t STEPS_PER_OCTAVE = 2;
+//! loads of an iteration of the chasing loop
+constexpr size_t UNROLL = 16;
+//! fewest pages of the tlb sweep
+constexpr size_t TLB_MIN_PAGES = 8;
+//! the pages of the tlb sweep grow by 2^(1/4) per step
+constexpr size_t TLB_STEPS_PER_OCTAVE = 4;
+//! relative and absolute difference in cycles to the median of a tlb level
+//! for a point to join it, the extra latency of the first level is about 0
+constexpr double TLB_TOLERANCE = 0.1;
+constexpr double TLB_TOLERANCE_CYCLES = 2;
+//! points of a tlb level, the shorter runs are transitions between levels
+constexpr size_t MIN_TLB_LEVEL_POINTS = 3;
+//! bounds of the capacity in pages and of the step in cycles over the level
+//! before of a level to be named after the tlb, the L1 dTLB hits have no
+//! extra latency, the L2 STLB hits a few cycles and the page walks more
+constexpr size_t MAX_L1_DTLB_ENTRIES = 256;
+constexpr size_t MAX_L2_STLB_ENTRIES = 8192;
+constexpr double MIN_STLB_STEP_CYCLES = 3;
+constexpr double MAX_STLB_STEP_CYCLES = 30;
+constexpr double MIN_PAGE_WALK_STEP_CYCLES = 5;
+
+enum class Chain { RANDOM, SEQUENTIAL };
+
+//! offsets of the first lines of a buffer, in the order of the chain
+std::vector<size_t> line_offsets(size_t nr_lines, Chain chain) {
+    std::vector<size_t> ret(nr_lines);
+    for (size_t i = 0; i < nr_lines; i++) {
+        ret[i] = i * CACHE_LINE;
+    }
+    if (chain == Chain::RANDOM) {
+        std::mt19937_64 rng(nr_lines);
+        std::shuffle(ret.begin(), ret.end(), rng);
+    }
+    return ret;
+}
+
+//! link the lines at the offsets of the buffer into a cycle, in the order of
+//! the offsets, \return the head of the chain
+void* link_chain(const Buffer& buffer, const std::vector<size_t>& offsets) {
+    auto base = buffer.as<char>();
+    for (size_t i = 0; i < offsets.size(); i++) {
+        auto line = reinterpret_cast<void**>(base + offsets[i]);
+        *line = base + offsets[(i + 1) % offsets.size()];
+    }
+    return base + offsets[0];
+}
+
+//! ns of a load of the chain
+Statistics chase(void* head) {
+    void* p = head;
+    KernelFunc kernel = [&p](size_t runs) {
+        void* q = p;
+        for (size_t i = 0; i < runs; i++) {
+#define cb(n) q = *static_cast<void**>(q);
+            UNROLL_CALL(16, cb)
+#undef cb
+        }
+        //! the next call goes on with the chain
+        p = q;
+        return runs * UNROLL;
+    };
+    size_t nr_runs = calibrate_runs(kernel);
+    size_t nr_samples = std::max<size_t>(get_options().nr_samples, 1);
+    std::vector<double> nsecs;
+    for (size_t i = 0; i < nr_samples; i++) {
+        Timer timer;
+        auto loads = kernel(nr_runs);
+        nsecs.push_back(timer.get_nsecs() / loads);
+    }
+    return compute_statistics(nsecs);
+}
+
+//! one line of each of the first nr_pages pages in a random order, the line
+//! moves along the page with the page index so that the lines spread over
+//! all the cache sets
+std::vector<size_t> page_offsets(size_t nr_pages, size_t page) {
+    std::vector<size_t> ret(nr_pages);
+    for (size_t i = 0; i < nr_pages; i++) {
+        ret[i] = i * page + i % (page / CACHE_LINE) * CACHE_LINE;
+    }
+    std::mt19937_64 rng(nr_pages);
+    std::shuffle(ret.begin(), ret.end(), rng);
+    return ret;
+}
+
+struct TlbPoint {
+    size_t nr_pages;
+    //! cycles of a load over the same lines packed in a few pages
+    double extra_cycles;
+};
+
+//! points of the tlb sweep with about the same extra latency
+struct TlbLevel {
+    size_t first_pages, last_pages;
+    double extra_cycles;
+};
+
+double median_cycles(const std::vector<TlbPoint>& points, size_t first,
+                     size_t last) {
+    std::vector<double> cycles;
+    for (size_t i = first; i <= last; i++) {
+        cycles.push_back(points[i].extra_cycles);
+    }
+    std::sort(cycles.begin(), cycles.end());
+    return cycles[cycles.size() / 2];
+}
+
+bool is_same_tlb_level(double lhs, double rhs) {
+    return std::fabs(lhs - rhs) <=
+           std::max(TLB_TOLERANCE * std::max(lhs, rhs), TLB_TOLERANCE_CYCLES);
+}
+
+/**
+ * split the extra latency into runs of points close to the median of the
+ * run like the plateaus of bandwidth_sweep(), the runs of
+ * MIN_TLB_LEVEL_POINTS points at least are the levels. The latency grows
+ * with every level, a run above the next one is a transition, the
+ * neighbouring runs left at the same latency are one level
+ */
+std::vector<TlbLevel> find_tlb_levels(const std::vector<TlbPoint>& points) {
+    std::vector<std::pair<size_t, size_t>> runs;
+    size_t first = 0;
+    for (size_t i = 1; i <= points.size(); i++) {
+        if (i == points.size() ||
+            !is_same_tlb_level(points[i].extra_cycles,
+                               median_cycles(points, first, i - 1))) {
+            if (i - first >= MIN_TLB_LEVEL_POINTS) {
+                runs.emplace_back(first, i - 1);
+            }
+            first = i;
+        }
+    }
+    std::vector<std::pair<size_t, size_t>> rising;
+    for (auto it = runs.rbegin(); it != runs.rend(); it++) {
+        if (rising.empty() ||
+            median_cycles(points, it->first, it->second) <
+                    median_cycles(points, rising.front().first,
+                                  rising.front().second)) {
+            rising.insert(rising.begin(), *it);
+        }
+    }
+    std::vector<TlbLevel> ret;
+    for (auto&& run : rising) {
+        double cycles = median_cycles(points, run.first, run.second);
+        if (!ret.empty() &&
+            is_same_tlb_level(ret.back().extra_cycles, cycles)) {
+            ret.back().last_pages = points[run.second].nr_pages;
+        } else {
+            ret.push_back({points[run.first].nr_pages,
+                           points[run.second].nr_pages, cycles});
+        }
+    }
+    return ret;
+}
+
+/**
+ * the name of each level when its capacity and step match the tlb level
+ * that comes next: the L1 dTLB from the first page count without extra
+ * latency, the L2 STLB, then the page walk. The levels after the first
+ * mismatch are not named, their steps are usually the page tables falling
+ * out of the data caches, or the translation of a virtual machine
+ */
+std::vector<std::string> name_tlb_levels(const std::vector<TlbLevel>& levels) {
+    std::vector<std::string> ret(levels.size());
+    for (size_t i = 0; i < levels.size(); i++) {
+        auto&& level = levels[i];
+        double step = i ? level.extra_cycles - levels[i - 1].extra_cycles
+                        : level.extra_cycles;
+        //! the first points may be noisy, the L1 dTLB covers them anyway
+        if (i == 0 && level.first_pages <= 2 * TLB_MIN_PAGES &&
+            step <= TLB_TOLERANCE_CYCLES &&
+            level.last_pages <= MAX_L1_DTLB_ENTRIES) {
+            ret[i] = "L1 dTLB";
+        } else if (i == 1 && !ret[0].empty() &&
+                   step >= MIN_STLB_STEP_CYCLES &&
+                   step <= MAX_STLB_STEP_CYCLES &&
+                   level.last_pages <= MAX_L2_STLB_ENTRIES) {
+            ret[i] = "L2 STLB";
+        } else if (i == 2 && !ret[1].empty() &&
+                   step >= MIN_PAGE_WALK_STEP_CYCLES) {
+            ret[i] = "page walk";
+        } else {
+            break;
+        }
+    }
+    return ret;
+}
+}  // namespace
+
+void megpeak::memory_latency(size_t max_bytes, PageSize pages) {
+    Buffer buffer(max_bytes, pages);
+    //! the first touch is on the pinned core
+    std::fill_n(buffer.as<uint8_t>(), max_bytes, 0);
+    buffer.check_huge_pages();
+    auto suite = page_suite("memory_latency", pages);
+    double mhz = measure_frequency();
+    printf("load-to-use latency by pointer chasing with %s pages, cycles at "
+           "%.0f MHz\n",
+           page_size_name(pages), mhz);
+    printf("%12s %14s %10s %14s %10s\n", "working set", "random ns",
+           "cycles", "sequential ns", "cycles");
+    size_t last = 0;
+    for (size_t step = 0;; step++) {
+        double exact =
+                MIN_BYTES * std::pow(2.0, double(step) / STEPS_PER_OCTAVE);
+        size_t bytes = size_t(exact) / CACHE_LINE * CACHE_LINE;
+        if (bytes > max_bytes) {
+            break;
+        }
+        if (bytes == last) {
+            continue;
+        }
+        last = bytes;
+        printf("%12s", format_size(bytes).c_str());
+        for (auto chain : {Chain::RANDOM, Chain::SEQUENTIAL}) {
+            auto stats = chase(link_chain(
+                    buffer, line_offsets(bytes / CACHE_LINE, chain)));
+            double cycles = stats.median * mhz / 1e3;
+            printf(" %14.2f %10.1f", stats.median, cycles);
+            std::string name =
+                    chain == Chain::RANDOM ? "random_" : "sequential_";
+            name += std::to_string(bytes);
+            report_result(suite, name, "", "latency", "ns", stats);
+            report_result(suite, name, "", "latency_cycles", "cycle",
+                          cycles);
+        }
+        printf("\n");
+    }
+    printf("\n");
+}
+
+void megpeak::tlb_reach(size_t max_span, PageSize pages) {
+    size_t page = page_bytes(pages);
+    size_t max_pages = max_span / page;
+    if (max_pages < TLB_MIN_PAGES) {
+        printf("tlb reach with %s pages: needs %zu pages at least, the span "
+               "is %zu pages\n\n",
+               page_size_name(pages), TLB_MIN_PAGES, max_pages);
+        return;
+    }
+    Buffer buffer(max_pages * page, pages);
+    std::fill_n(buffer.as<uint8_t>(), max_pages * page, 0);
+    buffer.check_huge_pages();
+    auto suite = page_suite("tlb", pages);
+    double mhz = measure_frequency();
+    printf("tlb reach with %s pages, one line per page against the same "
+           "lines packed, cycles at %.0f MHz\n",
+           page_size_name(pages), mhz);
+    printf("%10s %12s %12s %12s %12s\n", "pages", "span", "spread ns",
+           "packed ns", "extra cycles");
+    std::vector<TlbPoint> points;
+    size_t last = 0;
+    for (size_t step = 0;; step++) {
+        size_t nr_pages = size_t(
+                TLB_MIN_PAGES *
+                std::pow(2.0, double(step) / TLB_STEPS_PER_OCTAVE));
+        if (nr_pages > max_pages) {
+            break;
+        }
+        if (nr_pages == last) {
+            continue;
+        }
+        last = nr_pages;
+        auto spread = chase(link_chain(buffer, page_offsets(nr_pages, page)));
+        auto packed = chase(
+                link_chain(buffer, line_offsets(nr_pages, Chain::RANDOM)));
+        double extra = (spread.median - packed.median) * mhz / 1e3;
+        printf("%10zu %12s %12.2f %12.2f %12.1f\n", nr_pages,
+               format_size(nr_pages * page).c_str(), spread.median,
+               packed.median, extra);
+        std::string name = "pages_" + std::to_string(nr_pages);
+        report_result(suite, name, "", "latency", "ns", spread);
+        report_result(suite, name, "", "extra_latency", "cycle", extra);
+        points.push_back({nr_pages, extra});
+    }
+
+    auto levels = find_tlb_levels(points);
+    auto names = name_tlb_levels(levels);
+    for (size_t i = 0; i < levels.size(); i++) {
+        auto&& level = levels[i];
+        auto name = names[i].empty() ? "level " + std::to_string(i + 1)
+                                     : names[i];
+        double delta = i ? level.extra_cycles - levels[i - 1].extra_cycles
+                         : level.extra_cycles;
+        //! the noise of the levels would print as -0.0
+        if (std::fabs(delta) < 0.05) {
+            delta = 0;
+        }
+        //! the last level may go on beyond the span of the sweep
+        bool open = level.last_pages == points.back().nr_pages;
+        printf("%s: %.1f extra cycles, %+.1f over the previous level, from "
+               "%zu to %zu%s pages, reach %s%s\n",
+               name.c_str(), level.extra_cycles, delta, level.first_pages,
+               level.last_pages, open ? "+" : "",
+               format_size(level.last_pages * page).c_str(),
+               open ? "+" : "");
+        std::replace(name.begin(), name.end(), ' ', '_');
+        report_result(suite, name, "", "entries", "pages",
+                      double(level.last_pages));
+        report_result(suite, name, "", "extra_latency", "cycle",
+                      level.extra_cycles);
+        report_result(suite, name, "", "level_latency", "cycle", delta);
+    }
+    printf("\n");
+}
+
+// vim: syntax=cpp.doxygen
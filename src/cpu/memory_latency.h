@@ -0,0 +1,58 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+#pragma once
+
+#include <cstddef>
+
+#include "src/cpu/buffer.h"
+
+namespace megpeak {
+
+/**
+ * \brief load-to-use latency of the memory hierarchy by pointer chasing
+ *
+ * \param max_bytes largest working set, from 4 KiB
+ * \param pages pages of the working set
+ *
+ * the working set is split into cache lines, each one holds the address of
+ * the next line of a chain which goes through all of them, so every load
+ * depends on the previous one. The random chain is a random permutation of
+ * the lines, which defeats the prefetchers, the sequential chain walks the
+ * lines in order with a stride of a cache line, which the prefetchers
+ * follow. Both are printed in ns and cycles, the working set grows by
+ * 2^(1/2) per step.
+ */
+void memory_latency(size_t max_bytes, PageSize pages);
+
+/**
+ * \brief reach of the tlb levels and the cost of the page walks
+ *
+ * \param max_span largest span of the pages, from 8 pages
+ * \param pages pages of the span, the huge pages are 2 MiB
+ *
+ * a random chain touches one cache line in each of a growing number of
+ * pages, against a random chain over the same number of lines packed in
+ * consecutive pages, the difference is the cost of the translation. It stays
+ * about 0 while the pages fit in the L1 dTLB and steps up when they spill
+ * into the L2 STLB and again into the page walks, which slow down as the
+ * page tables fall out of the page walk caches and then of the data caches.
+ * The steps are found like the plateaus of bandwidth_sweep(), the capacity
+ * of each level is the last page count of its step. A level is only named
+ * L1 dTLB, L2 STLB or page walk when its capacity and step are those of the
+ * tlb level, the others are printed as level <i> with their page range. The
+ * packed chain touches 64 times fewer pages, so its own tlb misses shrink
+ * the extra latency of the largest spans a little.
+ */
+void tlb_reach(size_t max_span, PageSize pages);
+
+}  // namespace megpeak
+
+// vim: syntax=cpp.doxygen
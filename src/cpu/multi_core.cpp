@@ -0,0 +1,194 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/cpu/multi_core.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "src/backend.h"
+#include "src/cpu/topology.h"
+#include "src/options.h"
+#include "src/report.h"
+#include "src/statistics.h"
+
+using namespace megpeak;
+
+namespace {
+//! the workers wait for each other before every sample
+class Barrier {
+public:
+    explicit Barrier(size_t count) : m_count(count) {}
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        size_t generation = m_generation;
+        if (++m_nr_waiting == m_count) {
+            m_nr_waiting = 0;
+            m_generation++;
+            m_cv.notify_all();
+        } else {
+            m_cv.wait(lock, [&] { return generation != m_generation; });
+        }
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    size_t m_count;
+    size_t m_nr_waiting = 0;
+    size_t m_generation = 0;
+};
+
+void pin(size_t core) {
+    megpeak_assert(cpu_set_affinity(core) != -1,
+                   "Set CPU core affinity(%zu) failed.", core);
+}
+
+//! time of a chunk of the kernels run together, they check for the end of
+//! the sample between the chunks
+constexpr double CHUNK_MS = 1;
+
+//! instructions per ns of each kernel in every sample, all of them run on
+//! their core at once until the first one has run for --min-time
+std::vector<std::vector<double>> run_together(const std::vector<KernelFunc>& funcs,
+                                     const std::vector<size_t>& cores) {
+    size_t nr_threads = funcs.size();
+    size_t nr_samples = std::max<size_t>(get_options().nr_samples, 1);
+    double time_ms = get_options().min_time_ms;
+    Barrier barrier(nr_threads);
+    std::atomic<bool> stop{false};
+    std::vector<std::vector<double>> rates(nr_threads);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < nr_threads; i++) {
+        workers.emplace_back([&, i] {
+            auto&& func = funcs[i];
+            pin(cores[i]);
+            warm_up(func);
+            size_t chunk = calibrate_runs(func, CHUNK_MS);
+            for (size_t sample = 0; sample < nr_samples; sample++) {
+                barrier.wait();
+                if (i == 0) {
+                    stop = false;
+                }
+                barrier.wait();
+                Timer timer;
+                size_t insts = 0;
+                while (!stop) {
+                    insts += func(chunk);
+                    if (timer.get_msecs() >= time_ms) {
+                        stop = true;
+                    }
+                }
+                rates[i].push_back(insts / timer.get_nsecs());
+            }
+        });
+    }
+    for (auto&& worker : workers) {
+        worker.join();
+    }
+    return rates;
+}
+
+double median_rate(const std::vector<double>& rates) {
+    return compute_statistics(rates).median;
+}
+}  // namespace
+
+void megpeak::multi_core_benchmark(const KernelFunc& func, const char* name,
+                                   double work, const char* unit,
+                                   const std::string& suite,
+                                   const std::string& isa) {
+    multi_core_benchmark(func, work, func, name, work, unit, suite, isa);
+}
+
+void megpeak::multi_core_benchmark(const KernelFunc& single_func,
+                                   double single_work, const KernelFunc& func,
+                                   const char* name, double work,
+                                   const char* unit, const std::string& suite,
+                                   const std::string& isa) {
+    auto&& cores = get_options().cores;
+    size_t nr_cores = cores.size();
+    auto single = run_together({single_func}, {cores[0]})[0];
+    auto rates = run_together(std::vector<KernelFunc>(nr_cores, func), cores);
+    for (auto&& rate : single) {
+        rate *= single_work;
+    }
+    std::vector<double> aggregate(rates[0].size(), 0);
+    for (auto&& core : rates) {
+        for (size_t i = 0; i < core.size(); i++) {
+            core[i] *= work;
+            aggregate[i] += core[i];
+        }
+    }
+    auto total = compute_statistics(aggregate);
+    auto alone = compute_statistics(single);
+    printf("%s on %zu cores: aggregate %f %s, single core %f %s, scaling "
+           "%.2f of %zu\n",
+           name, nr_cores, total.median, unit, alone.median, unit,
+           total.median / alone.median, nr_cores);
+    report_result(suite, name, isa, "aggregate", unit, total);
+    report_result(suite, name, isa, "single", unit, alone);
+    for (size_t i = 0; i < nr_cores; i++) {
+        auto stat = compute_statistics(rates[i]);
+        printf("    core %zu: %f %s, min %f max %f\n", cores[i], stat.median,
+               unit, stat.min, stat.max);
+        report_result(suite, name, isa, "core" + std::to_string(cores[i]),
+                      unit, stat);
+    }
+}
+
+void megpeak::smt_interference(
+        const std::vector<const BenchmarkEntry*>& entries, size_t core) {
+    auto siblings = read_core_info(core).siblings;
+    auto it = std::find_if(siblings.begin(), siblings.end(),
+                           [&](size_t cpu) { return cpu != core; });
+    if (it == siblings.end()) {
+        printf("core %zu has no smt sibling online, thread_siblings_list is "
+               "\"%s\"\n",
+               core, format_cpu_list(siblings).c_str());
+        return;
+    }
+    std::vector<size_t> cores{core, *it};
+    printf("smt siblings %zu and %zu, rate of each thread relative to its "
+           "benchmark alone on it\n",
+           cores[0], cores[1]);
+
+    //! the rates alone on both threads, inst/ns
+    std::vector<double> alone[2];
+    for (auto entry : entries) {
+        for (size_t i = 0; i < 2; i++) {
+            alone[i].push_back(median_rate(
+                    run_together({entry->throughput}, {cores[i]})[0]));
+        }
+    }
+    for (size_t a = 0; a < entries.size(); a++) {
+        for (size_t b = a; b < entries.size(); b++) {
+            auto together = run_together(
+                    {entries[a]->throughput, entries[b]->throughput}, cores);
+            double first = median_rate(together[0]) / alone[0][a];
+            double second = median_rate(together[1]) / alone[1][b];
+            auto name = entries[a]->name + "+" + entries[b]->name;
+            printf("%-50s %.2f %.2f, sum %.2f\n", name.c_str(), first,
+                   second, first + second);
+            report_result("smt", name, "", "first_relative", "x", first);
+            report_result("smt", name, "", "second_relative", "x", second);
+        }
+    }
+    printf("\n");
+}
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,73 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "src/cpu/common.h"
+#include "src/cpu/registry.h"
+
+namespace megpeak {
+
+/**
+ * \brief run the kernel on all the cores of get_options().cores at once
+ *
+ * \param work operations or bytes of one instruction of the kernel, the
+ *      rate of a core is work / ns
+ * \param unit unit of the rate, e.g. GFlops
+ *
+ * the kernel is first sampled alone on the first core as the reference of
+ * the scaling. Then one worker thread is pinned to each core, it warms the
+ * kernel up and runs it in chunks of about a millisecond. Every sample
+ * starts at a barrier and all the cores stop as soon as one of them has run
+ * for --min-time, so that the cores are loaded together for the whole
+ * sample, which brings in the all-core turbo, the shared power limits and
+ * the contention on the shared caches and memory. The aggregate of a sample
+ * is the sum of the rates of the cores over the same window.
+ */
+void multi_core_benchmark(const KernelFunc& func, const char* name,
+                          double work, const char* unit,
+                          const std::string& suite, const std::string& isa);
+
+/**
+ * \brief like multi_core_benchmark(), with another kernel as the single core
+ * reference
+ *
+ * \param single_func kernel sampled alone on the first core, e.g. on larger
+ *      memory than the share of one core
+ * \param single_work work of one instruction of \p single_func
+ */
+void multi_core_benchmark(const KernelFunc& single_func, double single_work,
+                          const KernelFunc& func, const char* name,
+                          double work, const char* unit,
+                          const std::string& suite, const std::string& isa);
+
+/**
+ * \brief run the throughput kernels of two entries on the two smt threads of
+ * a core at once
+ *
+ * \param entries every pair of them is run, an entry also with itself
+ * \param core core of the first thread, the second thread is its first
+ *      sibling in the sysfs thread_siblings_list
+ *
+ * each thread runs its kernel in chunks of about a millisecond until one of
+ * them has run for --min-time, so that the threads overlap for the whole
+ * sample. The rate of each thread is printed relative to its kernel alone on
+ * the same thread, 1 when the siblings do not compete and 0.5 when they
+ * split the core evenly, the sum of both is the gain of smt.
+ */
+void smt_interference(const std::vector<const BenchmarkEntry*>& entries,
+                      size_t core);
+
+}  // namespace megpeak
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,268 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/cpu/perf_event.h"
+#include "src/backend.h"
+#include "src/options.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <memory>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace megpeak;
+
+#ifdef __linux__
+namespace {
+struct GenericEvent {
+    const char* name;
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr GenericEvent GENERIC_EVENTS[] = {
+        {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {"stalled-cycles-frontend", PERF_TYPE_HARDWARE,
+         PERF_COUNT_HW_STALLED_CYCLES_FRONTEND},
+        {"stalled-cycles-backend", PERF_TYPE_HARDWARE,
+         PERF_COUNT_HW_STALLED_CYCLES_BACKEND},
+        {"cache-references", PERF_TYPE_HARDWARE,
+         PERF_COUNT_HW_CACHE_REFERENCES},
+        {"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {"branches", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+        {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {"ref-cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_REF_CPU_CYCLES},
+};
+
+int open_event(uint32_t type, uint64_t config, int group_fd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = type;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    //! the members of a group are enabled with the leader
+    attr.disabled = group_fd < 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    if (group_fd < 0) {
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+    }
+    return syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+}  // namespace
+
+PerfEvent::PerfEvent(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = type;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    m_fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    if (m_fd < 0) {
+        m_errno = errno;
+    }
+}
+
+PerfEvent::~PerfEvent() {
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+void PerfEvent::start() {
+    if (m_fd < 0) {
+        return;
+    }
+    ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+uint64_t PerfEvent::stop() {
+    if (m_fd < 0) {
+        return 0;
+    }
+    ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+    uint64_t value = 0;
+    if (read(m_fd, &value, sizeof(value)) != sizeof(value)) {
+        return 0;
+    }
+    return value;
+}
+
+bool megpeak::parse_perf_event(const std::string& spec, PerfEventDesc& desc) {
+    for (auto&& event : GENERIC_EVENTS) {
+        if (spec == event.name) {
+            desc = {event.name, event.type, event.config};
+            return true;
+        }
+    }
+    std::string name = spec, raw = spec;
+    auto pos = spec.find('=');
+    if (pos != std::string::npos) {
+        name = spec.substr(0, pos);
+        raw = spec.substr(pos + 1);
+    }
+    if (raw.size() < 2 || raw[0] != 'r') {
+        return false;
+    }
+    char* end = nullptr;
+    uint64_t config = strtoull(raw.c_str() + 1, &end, 16);
+    if (*end != '\0' || name.empty()) {
+        return false;
+    }
+    desc = {name, PERF_TYPE_RAW, config};
+    return true;
+}
+
+std::vector<PerfEventDesc> megpeak::default_perf_events() {
+    std::vector<PerfEventDesc> ret;
+    for (size_t i = 0; i < 4; i++) {
+        auto&& event = GENERIC_EVENTS[i];
+        ret.push_back({event.name, event.type, event.config});
+    }
+    return ret;
+}
+
+PerfEventGroup::PerfEventGroup(const std::vector<PerfEventDesc>& events) {
+    for (auto&& event : events) {
+        int leader = m_fds.empty() ? -1 : m_fds[0];
+        int fd = open_event(event.type, event.config, leader);
+        if (fd < 0) {
+            if (leader < 0) {
+                m_errno = errno;
+                return;
+            }
+            //! the pmu does not know the event, count the others
+            m_dropped.push_back(event.name);
+            continue;
+        }
+        m_fds.push_back(fd);
+        m_names.push_back(event.name);
+    }
+}
+
+PerfEventGroup::~PerfEventGroup() {
+    for (auto fd : m_fds) {
+        close(fd);
+    }
+}
+
+void PerfEventGroup::start() {
+    if (m_fds.empty()) {
+        return;
+    }
+    ioctl(m_fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(m_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+bool PerfEventGroup::stop(std::vector<uint64_t>& values) {
+    values.assign(m_fds.size(), 0);
+    if (m_fds.empty()) {
+        return false;
+    }
+    ioctl(m_fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    //! nr, time_enabled, time_running, values...
+    std::vector<uint64_t> buf(3 + m_fds.size(), 0);
+    ssize_t size = buf.size() * sizeof(uint64_t);
+    if (read(m_fds[0], buf.data(), size) != size || buf[2] == 0) {
+        return false;
+    }
+    double scale = static_cast<double>(buf[1]) / buf[2];
+    for (size_t i = 0; i < m_fds.size(); i++) {
+        values[i] = static_cast<uint64_t>(buf[3 + i] * scale);
+    }
+    return true;
+}
+#else
+PerfEvent::PerfEvent(uint32_t, uint64_t) : m_errno{ENOSYS} {}
+PerfEvent::~PerfEvent() {}
+void PerfEvent::start() {}
+uint64_t PerfEvent::stop() {
+    return 0;
+}
+
+bool megpeak::parse_perf_event(const std::string&, PerfEventDesc&) {
+    return false;
+}
+std::vector<PerfEventDesc> megpeak::default_perf_events() {
+    return {};
+}
+
+PerfEventGroup::PerfEventGroup(const std::vector<PerfEventDesc>&)
+        : m_errno{ENOSYS} {}
+PerfEventGroup::~PerfEventGroup() {}
+void PerfEventGroup::start() {}
+bool PerfEventGroup::stop(std::vector<uint64_t>& values) {
+    values.clear();
+    return false;
+}
+#endif
+
+PerfEventGroup* megpeak::get_pmu_group() {
+    auto&& options = get_options();
+    if (!options.enable_pmu) {
+        return nullptr;
+    }
+    static thread_local std::unique_ptr<PerfEventGroup> group;
+    if (!group) {
+        auto events = default_perf_events();
+        std::vector<std::string> requested;
+        for (auto&& spec : options.pmu_events) {
+            PerfEventDesc desc;
+            megpeak_assert(parse_perf_event(spec, desc),
+                           "invalid pmu event: %s", spec.c_str());
+            events.push_back(desc);
+            requested.push_back(desc.name);
+        }
+        group = std::make_unique<PerfEventGroup>(events);
+        //! the default events are best effort, but the ones asked for on the
+        //! command line are expected in the results
+        static bool warned_dropped = false;
+        for (auto&& name : group->dropped()) {
+            if (!warned_dropped && std::find(requested.begin(), requested.end(),
+                                             name) != requested.end()) {
+                fprintf(stderr,
+                        "WARNING: pmu event %s can not be opened, continue "
+                        "without it\n",
+                        name.c_str());
+            }
+        }
+        warned_dropped = true;
+        if (!group->valid()) {
+            static bool warned = false;
+            if (!warned) {
+                fprintf(stderr,
+                        "WARNING: pmu counters are unavailable(%s), check "
+                        "/proc/sys/kernel/perf_event_paranoid, continue "
+                        "without them\n",
+                        strerror(group->error()));
+                warned = true;
+            }
+        }
+    }
+    return group->valid() ? group.get() : nullptr;
+}
+
+// vim: syntax=cpp.doxygen
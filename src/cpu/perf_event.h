@@ -0,0 +1,115 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace megpeak {
+
+/**
+ * \brief a single linux perf_event_open counter of the calling thread
+ *
+ * only user space events are counted. On the platforms without
+ * perf_event_open, or when the kernel refuses to open the counter
+ * (perf_event_paranoid, virtual machines without PMU), valid() is false and
+ * all the other methods are no-ops.
+ */
+class PerfEvent {
+public:
+    PerfEvent(uint32_t type, uint64_t config);
+    ~PerfEvent();
+    PerfEvent(const PerfEvent&) = delete;
+    PerfEvent& operator=(const PerfEvent&) = delete;
+
+    bool valid() const { return m_fd >= 0; }
+    //! errno of the failed perf_event_open, 0 if valid
+    int error() const { return m_errno; }
+
+    void start();
+    //! stop the counter and return the value counted since start()
+    uint64_t stop();
+
+private:
+    int m_fd = -1;
+    int m_errno = 0;
+};
+
+struct PerfEventDesc {
+    std::string name;
+    uint32_t type;
+    uint64_t config;
+};
+
+/**
+ * \brief parse an event spec of the command line
+ *
+ * the spec is either a generic event name (cycles, instructions,
+ * stalled-cycles-frontend, ...) or a raw pmu event in the perf syntax
+ * r<hex config>, e.g. r01b1 for UOPS_DISPATCHED.PORT_0 on skylake or r1b for
+ * INST_SPEC on arm. A raw event can be named as name=r<hex config>.
+ *
+ * \return false if the spec is invalid
+ */
+bool parse_perf_event(const std::string& spec, PerfEventDesc& desc);
+
+//! cycles, instructions and the frontend/backend stalled cycles
+std::vector<PerfEventDesc> default_perf_events();
+
+/**
+ * \brief a group of perf counters which are scheduled on the pmu together
+ *
+ * the first event is the group leader, if it can not be opened the whole
+ * group is invalid. The other events which the pmu does not support are
+ * dropped, see names() for the events which are really counted and
+ * dropped() for the others.
+ */
+class PerfEventGroup {
+public:
+    PerfEventGroup(const std::vector<PerfEventDesc>& events);
+    ~PerfEventGroup();
+    PerfEventGroup(const PerfEventGroup&) = delete;
+    PerfEventGroup& operator=(const PerfEventGroup&) = delete;
+
+    bool valid() const { return !m_fds.empty(); }
+    int error() const { return m_errno; }
+    const std::vector<std::string>& names() const { return m_names; }
+    const std::vector<std::string>& dropped() const { return m_dropped; }
+
+    void start();
+    /**
+     * \brief stop the group and read the values of names() since start()
+     *
+     * the values are scaled up if the group was multiplexed with other
+     * groups. \return false if the group was never scheduled on the pmu in
+     * between, the values are unknown rather than 0
+     */
+    bool stop(std::vector<uint64_t>& values);
+
+private:
+    std::vector<int> m_fds;
+    std::vector<std::string> m_names;
+    std::vector<std::string> m_dropped;
+    int m_errno = 0;
+};
+
+/**
+ * \brief the pmu group of the calling thread, configured by the options
+ *
+ * \return nullptr if the pmu is not enabled or not available
+ */
+PerfEventGroup* get_pmu_group();
+
+}  // namespace megpeak
+
+// vim: syntax=cpp.doxygen
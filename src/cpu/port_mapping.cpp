@@ -0,0 +1,360 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/cpu/port_mapping.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+
+#include "src/backend.h"
+#include "src/cpu/common.h"
+#include "src/cpu/jit.h"
+#include "src/report.h"
+
+using namespace megpeak;
+
+namespace {
+//! 8 instructions are 28 pairs and 56 triples, a few minutes
+constexpr size_t MAX_PORT_INSTS = 8;
+//! relative slowdown of a mix below which it is not counted as a conflict
+constexpr double PORT_TOLERANCE = 0.1;
+//! shared ports of a pair which is limited by the issue width
+constexpr int UNKNOWN_SHARED = -1;
+//! overlap of a pair above which it co-issues for free and below which it
+//! is serialised, see co_issue_matrix()
+constexpr double FREE_OVERLAP = 0.9, SERIAL_OVERLAP = 0.1;
+
+struct PortInst {
+    MixInst inst;
+    //! cycles per instruction alone
+    double cycles = 0;
+    size_t nr_ports = 1;
+    //! cycles a port is busy per instruction, about 1 if it is pipelined
+    double busy = 1;
+    //! index of the inferred ports
+    std::vector<size_t> ports;
+};
+
+using Group = std::vector<const PortInst*>;
+
+//! each instruction repeated as many times as it has ports, interleaved
+std::vector<MixInst> balanced_mix(const Group& group) {
+    size_t max_ports = 0;
+    for (auto inst : group) {
+        max_ports = std::max(max_ports, inst->nr_ports);
+    }
+    std::vector<MixInst> ret;
+    for (size_t i = 0; i < max_ports; i++) {
+        for (auto inst : group) {
+            if (i < inst->nr_ports) {
+                ret.push_back(inst->inst);
+            }
+        }
+    }
+    return ret;
+}
+
+std::string group_name(const Group& group) {
+    std::string ret;
+    for (auto inst : group) {
+        ret += (ret.empty() ? "" : " + ") + inst->inst.text;
+    }
+    return ret;
+}
+
+//! cycles of a pass over balanced_mix(), bound by the issue width and by the
+//! most loaded union of port sets
+double predict(const Group& group, double width) {
+    double total = 0;
+    for (auto inst : group) {
+        total += inst->nr_ports;
+    }
+    double ret = total / width;
+    for (size_t mask = 1; mask < (1u << group.size()); mask++) {
+        double load = 0;
+        std::vector<size_t> ports;
+        for (size_t i = 0; i < group.size(); i++) {
+            if (mask >> i & 1) {
+                load += group[i]->nr_ports * group[i]->busy;
+                ports.insert(ports.end(), group[i]->ports.begin(),
+                             group[i]->ports.end());
+            }
+        }
+        std::sort(ports.begin(), ports.end());
+        ports.erase(std::unique(ports.begin(), ports.end()), ports.end());
+        ret = std::max(ret, load / ports.size());
+    }
+    return ret;
+}
+
+/**
+ * the number of ports shared by a pair from the cycles of its balanced mix,
+ * the mix runs in the busy time of the slowest member if the ports are
+ * disjoint, otherwise its load is spread over the union of the ports
+ */
+int shared_ports(const PortInst& a, const PortInst& b, double cycles,
+                 double width) {
+    double total = a.nr_ports + b.nr_ports;
+    double load = a.nr_ports * a.busy + b.nr_ports * b.busy;
+    double issue = total / width;
+    double disjoint = std::max(a.busy, b.busy);
+    if (cycles > std::max(disjoint, issue) * (1 + PORT_TOLERANCE)) {
+        long shared = lround(total - load / cycles);
+        return std::min<long>(std::max<long>(shared, 1),
+                              std::min(a.nr_ports, b.nr_ports));
+    }
+    //! one shared port would not be slower than the issue width
+    if (load / (total - 1) <= issue * (1 + PORT_TOLERANCE)) {
+        return UNKNOWN_SHARED;
+    }
+    return 0;
+}
+
+/**
+ * assign the ports greedily, the instructions with the most ports first,
+ * each takes the existing ports which bring it closer to the shared count
+ * with the instructions already placed without exceeding any of them, then
+ * new ports
+ */
+void assign_ports(std::vector<PortInst>& table,
+                  const std::vector<std::vector<int>>& shared) {
+    std::vector<size_t> order(table.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+        return table[lhs].nr_ports > table[rhs].nr_ports;
+    });
+    auto has_port = [](const std::vector<size_t>& ports, size_t port) {
+        return std::find(ports.begin(), ports.end(), port) != ports.end();
+    };
+    std::vector<size_t> placed;
+    size_t nr_ports = 0;
+    for (auto i : order) {
+        auto& ports = table[i].ports;
+        while (ports.size() < table[i].nr_ports) {
+            size_t best = nr_ports, best_gain = 0;
+            for (size_t port = 0; port < nr_ports; port++) {
+                if (has_port(ports, port)) {
+                    continue;
+                }
+                size_t gain = 0;
+                bool valid = true;
+                for (auto j : placed) {
+                    int need = shared[i][j];
+                    if (need == UNKNOWN_SHARED ||
+                        !has_port(table[j].ports, port)) {
+                        continue;
+                    }
+                    int have = std::count_if(
+                            ports.begin(), ports.end(), [&](size_t p) {
+                                return has_port(table[j].ports, p);
+                            });
+                    if (have < need) {
+                        gain++;
+                    } else {
+                        valid = false;
+                    }
+                }
+                if (valid && gain > best_gain) {
+                    best = port;
+                    best_gain = gain;
+                }
+            }
+            if (best == nr_ports) {
+                nr_ports++;
+            }
+            ports.push_back(best);
+        }
+        std::sort(ports.begin(), ports.end());
+        placed.push_back(i);
+    }
+}
+
+void print_table(const std::vector<PortInst>& table) {
+    size_t nr_ports = 0, width = 0;
+    for (auto&& inst : table) {
+        nr_ports = std::max(nr_ports, inst.ports.back() + 1);
+        width = std::max(width, inst.inst.text.size());
+    }
+    printf("    inferred ports:\n    %*s", static_cast<int>(width), "");
+    for (size_t port = 0; port < nr_ports; port++) {
+        printf(" p%-2zu", port);
+    }
+    printf("\n");
+    for (auto&& inst : table) {
+        printf("    %-*s", static_cast<int>(width), inst.inst.text.c_str());
+        for (size_t port = 0; port < nr_ports; port++) {
+            bool used = std::find(inst.ports.begin(), inst.ports.end(),
+                                  port) != inst.ports.end();
+            printf("  %s ", used ? "x" : ".");
+        }
+        printf("\n");
+    }
+}
+}  // namespace
+
+void megpeak::infer_port_mapping(const std::string& mix) {
+    auto insts = parse_mix(mix);
+    megpeak_assert(insts.size() >= 2 && insts.size() <= MAX_PORT_INSTS,
+                   "the port mapping needs 2 to %zu instructions, got %zu",
+                   MAX_PORT_INSTS, insts.size());
+    //! nops issue at the full width and use no port
+    double width = 1 / mix_cycles(parse_mix("nop"));
+    printf("port mapping:\n");
+    printf("    issue width: %f inst/cycle\n", width);
+
+    std::vector<PortInst> table;
+    for (auto&& inst : insts) {
+        PortInst port;
+        port.inst = inst;
+        port.cycles = mix_cycles({inst});
+        port.nr_ports = std::max<long>(lround(1 / port.cycles), 1);
+        port.busy = port.cycles * port.nr_ports;
+        printf("    %s: %f cycle/inst %f inst/cycle, %zu ports\n",
+               inst.text.c_str(), port.cycles, 1 / port.cycles,
+               port.nr_ports);
+        report_result("ports", inst.text, "", "cycles", "cycle",
+                      port.cycles);
+        report_result("ports", inst.text, "", "ports", "ports",
+                      static_cast<double>(port.nr_ports));
+        table.emplace_back(std::move(port));
+    }
+
+    size_t nr_insts = table.size();
+    std::vector<std::vector<int>> shared(nr_insts,
+                                         std::vector<int>(nr_insts, 0));
+    printf("    pairs, each instruction repeated by its ports:\n");
+    for (size_t i = 0; i < nr_insts; i++) {
+        for (size_t j = i + 1; j < nr_insts; j++) {
+            Group pair = {&table[i], &table[j]};
+            double cycles = mix_cycles(balanced_mix(pair));
+            int count = shared_ports(table[i], table[j], cycles, width);
+            shared[i][j] = shared[j][i] = count;
+            printf("        %s: %f cycles, ", group_name(pair).c_str(),
+                   cycles);
+            if (count == UNKNOWN_SHARED) {
+                printf("bound by the issue width\n");
+            } else {
+                printf("%d shared ports\n", count);
+            }
+        }
+    }
+    assign_ports(table, shared);
+    print_table(table);
+
+    if (nr_insts < 3) {
+        return;
+    }
+    printf("    triples, measured against the table:\n");
+    size_t nr_mismatches = 0;
+    for (size_t i = 0; i < nr_insts; i++) {
+        for (size_t j = i + 1; j < nr_insts; j++) {
+            for (size_t k = j + 1; k < nr_insts; k++) {
+                Group triple = {&table[i], &table[j], &table[k]};
+                double cycles = mix_cycles(balanced_mix(triple));
+                double predicted = predict(triple, width);
+                double error = (cycles - predicted) / predicted;
+                bool mismatch = fabs(error) > PORT_TOLERANCE;
+                nr_mismatches += mismatch;
+                printf("        %s: %f cycles, predicted %f(%+.1f%%)%s\n",
+                       group_name(triple).c_str(), cycles, predicted,
+                       error * 100, mismatch ? " mismatch" : "");
+            }
+        }
+    }
+    if (nr_mismatches) {
+        printf("    %zu triples do not fit the table, their instructions "
+               "share ports in a way the pairs do not show\n",
+               nr_mismatches);
+    } else {
+        printf("    the table explains all the triples\n");
+    }
+}
+
+void megpeak::co_issue_matrix(const std::vector<std::string>& names,
+                              const std::vector<std::string>& mixes) {
+    size_t nr_insts = names.size();
+    if (nr_insts < 2) {
+        printf("co-issue matrix: less than 2 instructions are selected\n");
+        return;
+    }
+    std::vector<MixInst> insts;
+    std::vector<double> cycles;
+    printf("co-issue matrix, each pair interleaved 1:1 against the sum of "
+           "the isolated throughputs:\n");
+    for (size_t i = 0; i < nr_insts; i++) {
+        auto mix = parse_mix(mixes[i]);
+        megpeak_assert(mix.size() == 1, "%s is not a single instruction",
+                       mixes[i].c_str());
+        insts.push_back(mix[0]);
+        cycles.push_back(mix_cycles(mix));
+        printf("    %2zu: %s(%s) %f inst/cycle\n", i, names[i].c_str(),
+               mixes[i].c_str(), 1 / cycles[i]);
+    }
+
+    std::vector<std::vector<double>> ratio(nr_insts,
+                                           std::vector<double>(nr_insts, 1));
+    std::vector<std::string> lines;
+    for (size_t i = 0; i < nr_insts; i++) {
+        for (size_t j = i + 1; j < nr_insts; j++) {
+            //! cycles of a pass of one instruction of each
+            double pair = mix_cycles({insts[i], insts[j]});
+            double combined = 2 / pair;
+            double sum = 1 / cycles[i] + 1 / cycles[j];
+            ratio[i][j] = ratio[j][i] = combined / sum;
+            double free = std::max(cycles[i], cycles[j]);
+            double serial = cycles[i] + cycles[j];
+            double overlap = (serial - pair) / (serial - free);
+            const char* kind = overlap >= FREE_OVERLAP
+                                       ? "free"
+                                       : overlap <= SERIAL_OVERLAP
+                                                 ? "serialised"
+                                                 : "partial";
+            char line[256];
+            snprintf(line, sizeof(line),
+                     "    %s + %s: %f inst/cycle, sum %f, overlap %.0f%%, "
+                     "%s\n",
+                     names[i].c_str(), names[j].c_str(), combined, sum,
+                     overlap * 100, kind);
+            lines.push_back(line);
+            std::string name = names[i] + "+" + names[j];
+            report_result("pairs", name, "", "throughput", "inst/cycle",
+                          combined);
+            report_result("pairs", name, "", "ratio", "ratio",
+                          ratio[i][j]);
+            report_result("pairs", name, "", "overlap", "ratio", overlap);
+        }
+    }
+
+    printf("    %4s", "");
+    for (size_t j = 0; j < nr_insts; j++) {
+        printf(" %5zu", j);
+    }
+    printf("\n");
+    for (size_t i = 0; i < nr_insts; i++) {
+        printf("    %4zu", i);
+        for (size_t j = 0; j < nr_insts; j++) {
+            if (i == j) {
+                printf(" %5s", "-");
+            } else {
+                printf(" %4.0f%%", ratio[i][j] * 100);
+            }
+        }
+        printf("\n");
+    }
+    for (auto&& line : lines) {
+        printf("%s", line.c_str());
+    }
+}
+
+// vim: syntax=cpp.doxygen
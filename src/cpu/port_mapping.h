@@ -0,0 +1,57 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace megpeak {
+
+/**
+ * \brief infer the execution ports used by the instructions of a mix
+ *
+ * \param mix instructions in the --mix syntax, each one is a candidate of
+ *      the table, e.g. "vfmadd231ps ymm; vpaddd ymm; vmovups load"
+ *
+ * the throughput of every instruction alone gives the number of ports it can
+ * issue to. Every pair is then run with as many copies of each instruction
+ * as it has ports, the pair runs in the time of its slowest member if the
+ * ports are disjoint, any slowdown is the load of the shared ports. The
+ * ports are assigned greedily to match the shared counts of all the pairs,
+ * the table is checked against the throughput of every triple, the model of
+ * a mix is the most loaded union of port sets of its instructions.
+ *
+ * A pair which is limited by the issue width, measured with nops, can not
+ * tell shared ports, it is printed as such. Unpipelined instructions(div,
+ * sqrt) keep a port busy for several cycles, the table counts them as one
+ * port.
+ */
+void infer_port_mapping(const std::string& mix);
+
+/**
+ * \brief throughput of every pair of instructions interleaved 1:1
+ *
+ * \param names name of each instruction in the matrix
+ * \param mixes each instruction in the --mix syntax
+ *
+ * prints the N x N matrix of the throughput of each pair against the sum of
+ * the isolated throughputs of its instructions, 100% when two instructions of
+ * the same throughput co-issue for free and 50% when they serialise. Each
+ * pair is also classified by where its time falls between the slower
+ * instruction alone(free) and the sum of both(serialised), which does not
+ * depend on how different the two throughputs are.
+ */
+void co_issue_matrix(const std::vector<std::string>& names,
+                     const std::vector<std::string>& mixes);
+
+}  // namespace megpeak
+
+// vim: syntax=cpp.doxygen
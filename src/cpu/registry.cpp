@@ -0,0 +1,172 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/cpu/registry.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <regex>
+#include <sstream>
+
+#include "src/backend.h"
+#include "src/cpu/common.h"
+#include "src/cpu/multi_core.h"
+#include "src/options.h"
+
+using namespace megpeak;
+
+namespace {
+#if MEGPEAK_WITH_ALL_BENCHMARK
+constexpr bool RUN_EXTENDED = true;
+#else
+constexpr bool RUN_EXTENDED = false;
+#endif
+
+std::string join(const std::vector<std::string>& strs) {
+    std::string ret;
+    for (auto&& str : strs) {
+        ret += (ret.empty() ? "" : ",") + str;
+    }
+    return ret;
+}
+}  // namespace
+
+bool BenchmarkEntry::has_tag(const std::string& tag) const {
+    return std::find(tags.begin(), tags.end(), tag) != tags.end();
+}
+
+BenchmarkRegistry& BenchmarkRegistry::instance() {
+    static BenchmarkRegistry registry;
+    return registry;
+}
+
+BenchmarkEntry* BenchmarkRegistry::find(const std::string& suite,
+                                        const std::string& name) {
+    for (auto&& entry : m_entries) {
+        if (entry.suite == suite && entry.name == name) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+BenchmarkRegister::BenchmarkRegister(const char* suite, const char* name,
+                                     const char* isa, bool (*supported)(),
+                                     KernelFunc throughput,
+                                     KernelFunc latency,
+                                     size_t flops, const char* tags,
+                                     const char* msg) {
+    BenchmarkEntry entry;
+    entry.suite = suite;
+    entry.name = name;
+    entry.isa = isa;
+    entry.supported = supported;
+    entry.throughput = throughput;
+    entry.latency = latency;
+    entry.flops = flops;
+    entry.msg = msg;
+    std::stringstream ss(tags);
+    std::string tag;
+    while (std::getline(ss, tag, ',')) {
+        entry.tags.push_back(tag);
+    }
+    BenchmarkRegistry::instance().add(std::move(entry));
+}
+
+IlpSweepRegister::IlpSweepRegister(const char* suite, const char* name,
+                                   std::vector<KernelFunc> chains) {
+    auto entry = BenchmarkRegistry::instance().find(suite, name);
+    megpeak_assert(entry, "ilp sweep of unregistered benchmark %s", name);
+    entry->chains = std::move(chains);
+    entry->tags.push_back("ilp");
+}
+
+MixRegister::MixRegister(const char* suite, const char* name,
+                         const char* mix) {
+    auto entry = BenchmarkRegistry::instance().find(suite, name);
+    megpeak_assert(entry, "mix of unregistered benchmark %s", name);
+    entry->mix = mix;
+}
+
+bool megpeak::is_selected(const std::string& name,
+                          const std::vector<std::string>& tags) {
+    auto&& options = get_options();
+    if (!options.filter.empty()) {
+        static std::regex filter(options.filter);
+        if (!std::regex_search(name, filter)) {
+            return false;
+        }
+    }
+    if (!options.tags.empty()) {
+        bool found = false;
+        for (auto&& tag : options.tags) {
+            found |= std::find(tags.begin(), tags.end(), tag) != tags.end();
+        }
+        return found;
+    }
+    if (options.filter.empty() && !RUN_EXTENDED) {
+        return std::find(tags.begin(), tags.end(), "extended") == tags.end();
+    }
+    return true;
+}
+
+std::vector<const BenchmarkEntry*> megpeak::select_benchmarks(
+        const std::string& suite) {
+    std::vector<const BenchmarkEntry*> ret;
+    for (auto&& entry : BenchmarkRegistry::instance().entries()) {
+        if (entry.suite == suite && is_selected(entry.name, entry.tags) &&
+            entry.is_supported()) {
+            ret.push_back(&entry);
+        }
+    }
+    return ret;
+}
+
+void megpeak::run_benchmarks(const std::vector<const BenchmarkEntry*>& entries) {
+    auto ilp_chains = get_options().ilp_chains;
+    for (auto entry : entries) {
+        if (!get_options().cores.empty()) {
+            //! the kernels without flops are counted in instructions
+            bool flops = entry->flops > 0;
+            multi_core_benchmark(entry->throughput, entry->name.c_str(),
+                                 flops ? entry->flops : 1,
+                                 flops ? "GFlops" : "Ginst/s", entry->suite,
+                                 entry->isa);
+            continue;
+        }
+        if (ilp_chains) {
+            if (!entry->chains.empty()) {
+                ilp_sweep(entry->chains, entry->name.c_str(), entry->flops,
+                          entry->suite, entry->isa);
+            }
+            continue;
+        }
+        benchmark(entry->throughput, entry->latency, entry->name.c_str(),
+                  entry->flops, entry->msg, entry->suite, entry->isa);
+    }
+}
+
+void megpeak::list_benchmarks() {
+    printf("%-16s %-36s %-12s %-6s %-10s %s\n", "suite", "name", "isa",
+           "flops", "status", "tags");
+    for (auto&& entry : BenchmarkRegistry::instance().entries()) {
+        const char* status = !entry.is_supported()
+                                     ? "unsupported"
+                                     : (is_selected(entry.name, entry.tags)
+                                                ? "selected"
+                                                : "-");
+        printf("%-16s %-36s %-12s %-6zu %-10s %s\n", entry.suite.c_str(),
+               entry.name.c_str(), entry.isa.empty() ? "-" : entry.isa.c_str(),
+               entry.flops, status, join(entry.tags).c_str());
+    }
+}
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,127 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "src/cpu/common.h"
+
+namespace megpeak {
+
+/**
+ * \brief a throughput/latency kernel pair of a cpu suite
+ *
+ * entries tagged "extended" are only run when they are selected explicitly
+ * by --filter/--tag, or when built with MEGPEAK_WITH_ALL_BENCHMARK.
+ */
+struct BenchmarkEntry {
+    //! the suite function which runs the entry, e.g. x86_avx
+    std::string suite;
+    std::string name;
+    //! the isa extension the kernel requires, empty for the baseline isa
+    std::string isa;
+    //! runtime check of the isa, nullptr if the kernel always runs
+    bool (*supported)() = nullptr;
+    KernelFunc throughput;
+    KernelFunc latency;
+    //! operations done by one instruction, used to compute the GFlops
+    size_t flops = 0;
+    std::vector<std::string> tags;
+    std::string msg;
+    //! kernels with 1 ... N independent chains for --ilp, see ILP_SWEEP
+    std::vector<KernelFunc> chains;
+    //! the instruction in the --mix syntax for --pairs, empty if the jit
+    //! can not encode it
+    std::string mix;
+
+    bool is_supported() const { return !supported || supported(); }
+    bool has_tag(const std::string& tag) const;
+};
+
+class BenchmarkRegistry {
+public:
+    static BenchmarkRegistry& instance();
+
+    void add(BenchmarkEntry entry) { m_entries.emplace_back(std::move(entry)); }
+    //! all the entries, in registration order
+    const std::vector<BenchmarkEntry>& entries() const { return m_entries; }
+    //! the entry of the suite with the name, nullptr if not registered
+    BenchmarkEntry* find(const std::string& suite, const std::string& name);
+
+private:
+    std::vector<BenchmarkEntry> m_entries;
+};
+
+struct BenchmarkRegister {
+    //! \param tags comma separated tags
+    BenchmarkRegister(const char* suite, const char* name, const char* isa,
+                      bool (*supported)(), KernelFunc throughput,
+                      KernelFunc latency, size_t flops,
+                      const char* tags, const char* msg);
+};
+
+struct IlpSweepRegister {
+    IlpSweepRegister(const char* suite, const char* name,
+                     std::vector<KernelFunc> chains);
+};
+
+struct MixRegister {
+    MixRegister(const char* suite, const char* name, const char* mix);
+};
+
+/**
+ * \brief whether a benchmark is selected by --filter and --tag
+ *
+ * besides the registry entries, this is also used by the benchmarks which
+ * are not a throughput/latency pair, like the memory bandwidth.
+ */
+bool is_selected(const std::string& name, const std::vector<std::string>& tags);
+
+//! supported entries of the suite selected by --filter and --tag
+std::vector<const BenchmarkEntry*> select_benchmarks(const std::string& suite);
+
+/**
+ * benchmark all the entries, each one is warmed up by benchmark(). With
+ * --ilp only the entries with ilp kernels are run, by ilp_sweep(), with
+ * --threads/--cores the throughput kernels run on all the cores at once, by
+ * multi_core_benchmark()
+ */
+void run_benchmarks(const std::vector<const BenchmarkEntry*>& entries);
+
+//! print all the registered entries, for --list
+void list_benchmarks();
+
+/**
+ * register the func##_throughput and func##_latency kernels, the optional
+ * last argument is a message printed with the result
+ */
+#define MEGPEAK_REGISTER_BENCHMARK(suite, func, name, isa, supported, flops, \
+                                   tags, ...)                                \
+    static megpeak::BenchmarkRegister megpeak_register_##func(              \
+            #suite, name, isa, supported, func##_throughput,                \
+            func##_latency, flops, tags, "" __VA_ARGS__);
+
+//! attach the kernels of ILP_SWEEP(cb, func) to the registered entry
+#define MEGPEAK_REGISTER_ILP_SWEEP(suite, func, name)         \
+    static megpeak::IlpSweepRegister megpeak_register_ilp_##func( \
+            #suite, name, ILP_CHAINS(func));
+
+//! attach the --mix spelling of the instruction to the registered entry
+#define MEGPEAK_REGISTER_MIX(suite, func, name, mix)               \
+    static megpeak::MixRegister megpeak_register_mix_##func(#suite, name, \
+                                                             mix);
+
+}  // namespace megpeak
+
+// vim: syntax=cpp.doxygen
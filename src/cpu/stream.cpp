@@ -0,0 +1,430 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/cpu/stream.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+
+#include "src/cpu/buffer.h"
+#include "src/cpu/common.h"
+#include "src/cpu/multi_core.h"
+#include "src/cpu/registry.h"
+#include "src/cpu/topology.h"
+#include "src/options.h"
+#include "src/report.h"
+#include "src/statistics.h"
+
+using namespace megpeak;
+
+namespace {
+//! bytes of each array on one core without the cache sizes of sysfs, and
+//! the smallest arrays anyway
+constexpr size_t DEFAULT_BYTES = 64 * 1024 * 1024;
+//! each array is that many times the last level cache, so that the caches
+//! hold a negligible part of the arrays
+constexpr size_t LLC_FACTOR = 4;
+//! bytes of each array of a core with --cores, the arrays of all the cores
+//! are about the size of the single core ones, above this minimum
+constexpr size_t MIN_BYTES = 16 * 1024 * 1024;
+constexpr float SCALAR = 3.f;
+
+//! bytes of each array on one core, from the last level cache of the
+//! calling core, which is pinned
+size_t array_bytes() {
+    auto caches = read_cache_info(get_current_cpu());
+    size_t llc = caches.empty() ? 0 : caches.back().bytes;
+    return std::max(LLC_FACTOR * llc, DEFAULT_BYTES);
+}
+
+//! elements of each array of the given bytes
+size_t array_elems(size_t bytes) {
+    return bytes / sizeof(float) / STREAM_BLOCK * STREAM_BLOCK;
+}
+
+//! the three arrays of the kernels, first touched by the calling thread
+struct StreamArrays {
+    Buffer a, b, c;
+    size_t n;
+
+    StreamArrays(size_t bytes, PageSize pages)
+            : a(bytes, pages), b(bytes, pages), c(bytes, pages) {
+        n = array_elems(bytes);
+        std::fill_n(a.as<float>(), n, 1.f);
+        std::fill_n(b.as<float>(), n, 2.f);
+        std::fill_n(c.as<float>(), n, 0.5f);
+        a.check_huge_pages();
+    }
+
+    float run(StreamFunc func) {
+        return func(a.as<float>(), b.as<float>(), c.as<float>(), n, SCALAR);
+    }
+};
+
+//! GB/s of the samples of the kernel, which moves bytes in one run
+Statistics measure_bandwidth(StreamFunc func, float* a, const float* b,
+                             const float* c, size_t n, double bytes) {
+    volatile float res = 0;
+    KernelFunc kernel = [&](size_t runs) {
+        for (size_t i = 0; i < runs; i++) {
+            res = res + func(a, b, c, n, SCALAR);
+        }
+        return runs;
+    };
+    warm_up(kernel);
+    size_t nr_runs = calibrate_runs(kernel);
+    size_t nr_samples = std::max<size_t>(get_options().nr_samples, 1);
+    std::vector<double> gbps;
+    for (size_t i = 0; i < nr_samples; i++) {
+        Timer timer;
+        kernel(nr_runs);
+        gbps.push_back(bytes * nr_runs / timer.get_nsecs());
+    }
+    return compute_statistics(gbps);
+}
+
+void single_core(StreamArrays& arrays, StreamFunc func, StreamOp op,
+                 const std::string& name, const char* isa, PageSize pages) {
+    auto stats = measure_bandwidth(func, arrays.a.as<float>(),
+                                   arrays.b.as<float>(), arrays.c.as<float>(),
+                                   arrays.n, stream_bytes(op, arrays.n));
+    printf("%s: %f GB/s, min %f max %f\n", name.c_str(), stats.median,
+           stats.min, stats.max);
+    report_result(page_suite("memory", pages), name, isa, "bandwidth", "GB/s",
+                  stats);
+}
+
+//! the kernel on arrays of the given bytes, allocated by the first call of
+//! each worker thread, run_together() starts new workers every time
+KernelFunc stream_kernel(StreamFunc func, size_t bytes, PageSize pages) {
+    return [func, bytes, pages](size_t runs) {
+        //! the first touch is on the core of the worker
+        static thread_local StreamArrays arrays(bytes, pages);
+        volatile float res = 0;
+        for (size_t i = 0; i < runs; i++) {
+            res = res + arrays.run(func);
+        }
+        return runs;
+    };
+}
+
+void multi_core(StreamFunc func, StreamOp op, const std::string& name,
+                const char* isa, PageSize pages) {
+    //! the single core reference runs on the arrays of a single core run,
+    //! the share of a core may fit in the last level cache
+    size_t single_bytes = array_bytes();
+    size_t nr_bytes =
+            std::max(single_bytes / get_options().cores.size(), MIN_BYTES);
+    multi_core_benchmark(stream_kernel(func, single_bytes, pages),
+                         stream_bytes(op, array_elems(single_bytes)),
+                         stream_kernel(func, nr_bytes, pages), name.c_str(),
+                         stream_bytes(op, array_elems(nr_bytes)), "GB/s",
+                         page_suite("memory", pages), isa);
+}
+
+//! smallest working set of the sweep
+constexpr size_t SWEEP_MIN_BYTES = 4 * 1024;
+//! the working set of the sweep grows by 2^(1/4) per step
+constexpr size_t SWEEP_STEPS_PER_OCTAVE = 4;
+//! relative difference to the median of a plateau for a point to join it
+constexpr double PLATEAU_TOLERANCE = 0.1;
+//! points of a plateau, the shorter runs are transitions between levels
+constexpr size_t MIN_PLATEAU_POINTS = 3;
+
+struct SweepPoint {
+    //! the working set, the sum of the arrays of the kernel
+    size_t bytes;
+    double gbps;
+};
+
+//! points of the sweep with about the same bandwidth, a level of the
+//! memory hierarchy
+struct Plateau {
+    size_t first_bytes, last_bytes;
+    double gbps;
+    size_t nr_points;
+};
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+//! median bandwidth of the points first ... last
+double median_gbps(const std::vector<SweepPoint>& points, size_t first,
+                   size_t last) {
+    std::vector<double> gbps;
+    for (size_t i = first; i <= last; i++) {
+        gbps.push_back(points[i].gbps);
+    }
+    return median(gbps);
+}
+
+bool is_same_level(double lhs, double rhs) {
+    return std::fabs(lhs - rhs) <= PLATEAU_TOLERANCE * std::max(lhs, rhs);
+}
+
+/**
+ * split the curve into runs of points within PLATEAU_TOLERANCE of the median
+ * of the run, the runs of MIN_PLATEAU_POINTS points at least are the
+ * plateaus, the others are the transitions between them. Neighbouring
+ * plateaus split by a noisy point are merged back, and the first plateau is
+ * dropped when it is below the second one
+ */
+std::vector<Plateau> find_plateaus(const std::vector<SweepPoint>& points) {
+    //! first and last point of the runs
+    std::vector<std::pair<size_t, size_t>> runs;
+    size_t first = 0;
+    for (size_t i = 1; i <= points.size(); i++) {
+        if (i == points.size() ||
+            !is_same_level(points[i].gbps, median_gbps(points, first, i - 1))) {
+            if (i - first >= MIN_PLATEAU_POINTS) {
+                runs.emplace_back(first, i - 1);
+            }
+            first = i;
+        }
+    }
+    std::vector<std::pair<size_t, size_t>> merged;
+    for (auto&& run : runs) {
+        if (!merged.empty() &&
+            is_same_level(
+                    median_gbps(points, merged.back().first,
+                                merged.back().second),
+                    median_gbps(points, run.first, run.second))) {
+            merged.back().second = run.second;
+        } else {
+            merged.push_back(run);
+        }
+    }
+    std::vector<Plateau> ret;
+    for (auto&& run : merged) {
+        ret.push_back({points[run.first].bytes, points[run.second].bytes,
+                       median_gbps(points, run.first, run.second),
+                       run.second - run.first + 1});
+    }
+    //! a plateau from the smallest working set below the next one is bound
+    //! by the overhead of the calls, the later ones are all kept, e.g. the
+    //! tlb reach splits a cache level
+    if (ret.size() > 1 && ret[0].first_bytes == points.front().bytes &&
+        ret[0].gbps < ret[1].gbps) {
+        ret.erase(ret.begin());
+    }
+    return ret;
+}
+
+/**
+ * the cache level of each plateau from the cache sizes of sysfs, a plateau
+ * is in a level when all its working sets are above the size of the level
+ * below and up to the size of the level, it is the dram when it starts above
+ * the last level cache. When several plateaus are in the same level, e.g.
+ * split by the reach of the tlb, the one with the most points gets the
+ * name. The others and the plateaus between the levels get no name
+ */
+std::vector<std::string> match_cache_levels(
+        const std::vector<Plateau>& plateaus) {
+    std::vector<std::string> ret(plateaus.size());
+    auto caches = read_cache_info(get_current_cpu());
+    if (caches.empty()) {
+        return ret;
+    }
+    std::vector<size_t> best(caches.size() + 1, plateaus.size());
+    for (size_t i = 0; i < plateaus.size(); i++) {
+        auto&& plateau = plateaus[i];
+        size_t below = 0;
+        for (size_t level = 0; level <= caches.size(); level++) {
+            bool dram = level == caches.size();
+            if (plateau.first_bytes > below &&
+                (dram || plateau.last_bytes <= caches[level].bytes)) {
+                if (best[level] == plateaus.size() ||
+                    plateau.nr_points > plateaus[best[level]].nr_points) {
+                    best[level] = i;
+                }
+                break;
+            }
+            if (!dram) {
+                below = caches[level].bytes;
+            }
+        }
+    }
+    for (size_t level = 0; level <= caches.size(); level++) {
+        if (best[level] < plateaus.size()) {
+            ret[best[level]] =
+                    level == caches.size()
+                            ? "DRAM"
+                            : "L" + std::to_string(caches[level].level);
+        }
+    }
+    return ret;
+}
+
+//! the working set sweep of one kernel with regular stores, the arrays of
+//! the kernel are carved from the buffer
+void sweep_kernel(StreamFunc func, StreamOp op, const std::string& name,
+                  const char* isa, const Buffer& buffer, PageSize pages) {
+    auto suite = page_suite("memory_sweep", pages);
+    size_t nr_arrays = op == StreamOp::COPY ? 2 : 1;
+    size_t block_bytes = nr_arrays * STREAM_BLOCK * sizeof(float);
+    std::vector<SweepPoint> points;
+    printf("%s working set sweep with %s pages:\n", name.c_str(),
+           page_size_name(pages));
+    size_t last = 0;
+    for (size_t step = 0;; step++) {
+        double exact = SWEEP_MIN_BYTES *
+                       std::pow(2.0, double(step) / SWEEP_STEPS_PER_OCTAVE);
+        size_t bytes = size_t(exact) / block_bytes * block_bytes;
+        if (bytes > buffer.size()) {
+            break;
+        }
+        if (bytes == last) {
+            continue;
+        }
+        last = bytes;
+        size_t n = bytes / nr_arrays / sizeof(float);
+        float* a = buffer.as<float>();
+        auto stats = measure_bandwidth(func, a, a + n, nullptr, n,
+                                       stream_bytes(op, n));
+        printf("    %10s: %f GB/s\n", format_size(bytes).c_str(),
+               stats.median);
+        report_result(suite, name + "_" + std::to_string(bytes), isa,
+                      "bandwidth", "GB/s", stats);
+        points.push_back({bytes, stats.median});
+    }
+
+    auto plateaus = find_plateaus(points);
+    auto levels = match_cache_levels(plateaus);
+    for (size_t i = 0; i < plateaus.size(); i++) {
+        auto&& plateau = plateaus[i];
+        auto range = format_size(plateau.first_bytes) + " to " +
+                     format_size(plateau.last_bytes);
+        if (levels[i].empty()) {
+            printf("%s plateau: %f GB/s from %s\n", name.c_str(),
+                   plateau.gbps, range.c_str());
+            report_result(suite,
+                          name + "_plateau_" +
+                                  std::to_string(plateau.first_bytes) + "_" +
+                                  std::to_string(plateau.last_bytes),
+                          isa, "bandwidth", "GB/s", plateau.gbps);
+        } else {
+            printf("%s %s: %f GB/s from %s\n", name.c_str(),
+                   levels[i].c_str(), plateau.gbps, range.c_str());
+            report_result(suite, name + "_" + levels[i], isa, "bandwidth",
+                          "GB/s", plateau.gbps);
+        }
+    }
+    printf("\n");
+}
+}  // namespace
+
+const char* megpeak::stream_op_name(StreamOp op) {
+    switch (op) {
+        case StreamOp::READ:
+            return "read";
+        case StreamOp::WRITE:
+            return "write";
+        case StreamOp::COPY:
+            return "copy";
+        case StreamOp::SCALE:
+            return "scale";
+        case StreamOp::ADD:
+            return "add";
+        case StreamOp::TRIAD:
+            return "triad";
+    }
+    return "unknown";
+}
+
+size_t megpeak::stream_bytes(StreamOp op, size_t n) {
+    switch (op) {
+        case StreamOp::READ:
+        case StreamOp::WRITE:
+            return n * sizeof(float);
+        case StreamOp::COPY:
+        case StreamOp::SCALE:
+            return 2 * n * sizeof(float);
+        case StreamOp::ADD:
+        case StreamOp::TRIAD:
+            return 3 * n * sizeof(float);
+    }
+    return 0;
+}
+
+void megpeak::stream_bandwidth(PageSize pages) {
+    std::unique_ptr<StreamArrays> arrays;
+    bool selected = false;
+    for (auto&& kernels : get_stream_kernels()) {
+        if (kernels.supported && !kernels.supported()) {
+            continue;
+        }
+        for (size_t i = 0; i < NR_STREAM_OPS; i++) {
+            auto op = static_cast<StreamOp>(i);
+            for (auto func : {kernels.regular[i], kernels.non_temporal[i]}) {
+                if (!func) {
+                    continue;
+                }
+                std::string name = stream_op_name(op);
+                name += func == kernels.non_temporal[i] ? "_nt_" : "_";
+                name += kernels.isa;
+                if (!is_selected(name, {"memory", "stream"})) {
+                    continue;
+                }
+                if (!selected) {
+                    printf("STREAM bandwidth with %s pages, arrays of %s:\n",
+                           page_size_name(pages),
+                           format_size(array_bytes()).c_str());
+                    selected = true;
+                }
+                if (get_options().cores.empty()) {
+                    if (!arrays) {
+                        arrays.reset(new StreamArrays(array_bytes(), pages));
+                    }
+                    single_core(*arrays, func, op, name, kernels.isa, pages);
+                } else {
+                    multi_core(func, op, name, kernels.isa, pages);
+                }
+            }
+        }
+    }
+    if (selected) {
+        printf("\n");
+    }
+}
+
+void megpeak::bandwidth_sweep(size_t max_bytes, PageSize pages) {
+    const StreamKernels* widest = nullptr;
+    for (auto&& kernels : get_stream_kernels()) {
+        if (!kernels.supported || kernels.supported()) {
+            widest = &kernels;
+        }
+    }
+    if (!widest) {
+        printf("no stream kernel is supported\n");
+        return;
+    }
+    Buffer buffer(max_bytes, pages);
+    //! the first touch is on the pinned core
+    std::fill_n(buffer.as<uint8_t>(), max_bytes, 0);
+    buffer.check_huge_pages();
+    for (auto op : {StreamOp::READ, StreamOp::WRITE, StreamOp::COPY}) {
+        std::string name = stream_op_name(op);
+        name += "_";
+        name += widest->isa;
+        if (is_selected(name, {"memory", "stream"})) {
+            sweep_kernel(widest->regular[size_t(op)], op, name, widest->isa,
+                         buffer, pages);
+        }
+    }
+}
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,95 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "src/cpu/buffer.h"
+
+namespace megpeak {
+
+//! the kernels of the STREAM benchmark, a is written and b, c are read
+enum class StreamOp {
+    READ,   //!< sum += a
+    WRITE,  //!< a = s
+    COPY,   //!< a = b
+    SCALE,  //!< a = s * b
+    ADD,    //!< a = b + c
+    TRIAD,  //!< a = b + s * c
+};
+constexpr size_t NR_STREAM_OPS = 6;
+
+//! the number of floats of the arrays is a multiple of it, an iteration of
+//! the widest read kernel, 16 vectors of 512 bits
+constexpr size_t STREAM_BLOCK = 256;
+
+/**
+ * \brief a kernel over arrays of n floats, 64 bytes aligned
+ *
+ * \return the sum of read, 0 for the other kernels
+ */
+using StreamFunc = float (*)(float* a, const float* b, const float* c,
+                             size_t n, float s);
+
+//! the kernels written with the simd instructions of an isa
+struct StreamKernels {
+    const char* isa;
+    //! runtime check of the isa, nullptr if the kernels always run
+    bool (*supported)();
+    //! indexed by StreamOp
+    StreamFunc regular[NR_STREAM_OPS];
+    //! the kernels with non-temporal stores, nullptr for read and when the
+    //! isa has no such store
+    StreamFunc non_temporal[NR_STREAM_OPS];
+};
+
+//! the kernels of the arch, defined in stream_<arch>.cpp
+std::vector<StreamKernels> get_stream_kernels();
+
+//! "read", "write" ...
+const char* stream_op_name(StreamOp op);
+
+/**
+ * bytes moved by a kernel over arrays of n floats, the reads of the cache
+ * lines allocated by the regular stores are not counted, as in STREAM, so
+ * the regular kernels which write are below the non-temporal ones when the
+ * write allocate traffic costs bandwidth
+ */
+size_t stream_bytes(StreamOp op, size_t n);
+
+/**
+ * \brief the STREAM bandwidth of every kernel of every supported isa, in
+ * regular and non-temporal stores variants
+ *
+ * the arrays are several times the last level cache, the benchmarks are
+ * named <op>_<isa> and <op>_nt_<isa>, and are selected by --filter/--tag
+ * with the tags memory and stream. With --threads/--cores all the cores run
+ * the kernel at once on their own arrays, see multi_core_benchmark(), the
+ * single core reference keeps the arrays of a single core run.
+ */
+void stream_bandwidth(PageSize pages);
+
+/**
+ * \brief bandwidth of the read, write and copy kernels of the widest
+ * supported isa over working sets from 4 KiB to max_bytes
+ *
+ * the working set grows by 2^(1/4) per step and is the sum of the arrays of
+ * the kernel. The plateaus of the curve are found automatically and named
+ * after the cache level of sysfs their working sets fit in, or the dram
+ * when they start beyond the last level cache. The plateaus which match no
+ * level are printed with their working sets only
+ */
+void bandwidth_sweep(size_t max_bytes, PageSize pages);
+
+}  // namespace megpeak
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,137 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/cpu/stream.h"
+
+#if MEGPEAK_AARCH64 || MEGPEAK_ARMV7
+#include <arm_neon.h>
+
+#include "src/cpu/common.h"
+
+using namespace megpeak;
+
+namespace {
+//! store 2 vectors to p
+inline void store2(float* p, float32x4_t lo, float32x4_t hi) {
+    vst1q_f32(p, lo);
+    vst1q_f32(p + 4, hi);
+}
+
+#if MEGPEAK_AARCH64
+//! store 2 vectors to p with the non-temporal hint of stnp, there is no
+//! non-temporal store of one q register
+inline void store2_nt(float* p, float32x4_t lo, float32x4_t hi) {
+    asm volatile("stnp %q[lo], %q[hi], [%[p]]\n"
+                 :
+                 : [p] "r"(p), [lo] "w"(lo), [hi] "w"(hi)
+                 : "memory");
+}
+#endif
+
+//! independent sums of the read kernel, the fadd latency times the loads per
+//! cycle, the loads go to the other 8 q registers of armv7
+#define READ_CHAINS 8
+float read_neon(float* a, const float*, const float*, size_t n, float) {
+#define cb(i) float32x4_t sum##i = vdupq_n_f32(0.f);
+    UNROLL_CALL(READ_CHAINS, cb)
+#undef cb
+    for (size_t k = 0; k < n; k += READ_CHAINS * 4) {
+#define cb(i) sum##i = vaddq_f32(sum##i, vld1q_f32(a + k + i * 4));
+        UNROLL_CALL(READ_CHAINS, cb)
+#undef cb
+    }
+    float32x4_t total = vdupq_n_f32(0.f);
+#define cb(i) total = vaddq_f32(total, sum##i);
+    UNROLL_CALL(READ_CHAINS, cb)
+#undef cb
+    float ret[4];
+    vst1q_f32(ret, total);
+    return ret[0] + ret[1] + ret[2] + ret[3];
+}
+
+//! the kernels which write a, 4 vectors per iteration, stored in pairs
+// clang-format off
+#define WRITE_KERNELS(suffix, store2)                                          \
+    float write_##suffix(float* a, const float*, const float*, size_t n,       \
+                         float s) {                                            \
+        float32x4_t vs = vdupq_n_f32(s);                                       \
+        for (size_t i = 0; i < n; i += 16) {                                   \
+            store2(a + i, vs, vs);                                             \
+            store2(a + i + 8, vs, vs);                                         \
+        }                                                                      \
+        return 0;                                                              \
+    }                                                                          \
+    float copy_##suffix(float* a, const float* b, const float*, size_t n,      \
+                        float) {                                               \
+        for (size_t i = 0; i < n; i += 16) {                                   \
+            store2(a + i, vld1q_f32(b + i), vld1q_f32(b + i + 4));             \
+            store2(a + i + 8, vld1q_f32(b + i + 8), vld1q_f32(b + i + 12));    \
+        }                                                                      \
+        return 0;                                                              \
+    }                                                                          \
+    float scale_##suffix(float* a, const float* b, const float*, size_t n,     \
+                         float s) {                                            \
+        for (size_t i = 0; i < n; i += 16) {                                   \
+            store2(a + i, vmulq_n_f32(vld1q_f32(b + i), s),                    \
+                   vmulq_n_f32(vld1q_f32(b + i + 4), s));                      \
+            store2(a + i + 8, vmulq_n_f32(vld1q_f32(b + i + 8), s),            \
+                   vmulq_n_f32(vld1q_f32(b + i + 12), s));                     \
+        }                                                                      \
+        return 0;                                                              \
+    }                                                                          \
+    float add_##suffix(float* a, const float* b, const float* c, size_t n,     \
+                       float) {                                                \
+        for (size_t i = 0; i < n; i += 16) {                                   \
+            store2(a + i, vaddq_f32(vld1q_f32(b + i), vld1q_f32(c + i)),       \
+                   vaddq_f32(vld1q_f32(b + i + 4), vld1q_f32(c + i + 4)));     \
+            store2(a + i + 8,                                                  \
+                   vaddq_f32(vld1q_f32(b + i + 8), vld1q_f32(c + i + 8)),      \
+                   vaddq_f32(vld1q_f32(b + i + 12), vld1q_f32(c + i + 12)));   \
+        }                                                                      \
+        return 0;                                                              \
+    }                                                                          \
+    float triad_##suffix(float* a, const float* b, const float* c, size_t n,   \
+                         float s) {                                            \
+        for (size_t i = 0; i < n; i += 16) {                                   \
+            store2(a + i, vmlaq_n_f32(vld1q_f32(b + i), vld1q_f32(c + i), s),  \
+                   vmlaq_n_f32(vld1q_f32(b + i + 4), vld1q_f32(c + i + 4),     \
+                               s));                                            \
+            store2(a + i + 8,                                                  \
+                   vmlaq_n_f32(vld1q_f32(b + i + 8), vld1q_f32(c + i + 8), s), \
+                   vmlaq_n_f32(vld1q_f32(b + i + 12), vld1q_f32(c + i + 12),   \
+                               s));                                            \
+        }                                                                      \
+        return 0;                                                              \
+    }
+// clang-format on
+
+WRITE_KERNELS(neon, store2)
+#if MEGPEAK_AARCH64
+WRITE_KERNELS(nt_neon, store2_nt)
+#endif
+}  // namespace
+
+std::vector<StreamKernels> megpeak::get_stream_kernels() {
+    return {{"neon",
+             nullptr,
+             {read_neon, write_neon, copy_neon, scale_neon, add_neon,
+              triad_neon},
+#if MEGPEAK_AARCH64
+             {nullptr, write_nt_neon, copy_nt_neon, scale_nt_neon,
+              add_nt_neon, triad_nt_neon}
+#else
+             {}
+#endif
+            }};
+}
+#endif
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,164 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/cpu/stream.h"
+
+#if MEGPEAK_LOONGARCH
+#include "src/cpu/loongarch_utils.h"
+
+using namespace megpeak;
+
+//! the kernels handle 4 vectors(32 floats) of each array per iteration, xr8
+//! holds the scalar. LASX has no non-temporal store.
+// clang-format off
+#define LOAD4(ptr, r0, r1, r2, r3)                 \
+    "xvld   $xr" #r0 ", %[" #ptr "], 0\n"          \
+    "xvld   $xr" #r1 ", %[" #ptr "], 32\n"         \
+    "xvld   $xr" #r2 ", %[" #ptr "], 64\n"         \
+    "xvld   $xr" #r3 ", %[" #ptr "], 96\n"
+#define STORE4(ptr, r0, r1, r2, r3)                \
+    "xvst   $xr" #r0 ", %[" #ptr "], 0\n"          \
+    "xvst   $xr" #r1 ", %[" #ptr "], 32\n"         \
+    "xvst   $xr" #r2 ", %[" #ptr "], 64\n"         \
+    "xvst   $xr" #r3 ", %[" #ptr "], 96\n"
+#define NEXT(ptr) "addi.d  %[" #ptr "], %[" #ptr "], 128\n"
+#define LOOP_END                                   \
+    "addi.d  %[n], %[n], -32\n"                    \
+    "bnez    %[n], 1b\n"
+#define CLOBBERS                                                           \
+    "memory", "$f0", "$f1", "$f2", "$f3", "$f4", "$f5", "$f6", "$f7", "$f8"
+// clang-format on
+
+namespace {
+//! the read kernel keeps 8 independent sums in xr0-xr7, twice the 4
+//! vectors of the other kernels, so that the fadd latency does not throttle
+//! the 2 load ports
+float read_lasx(float* a, const float*, const float*, size_t n, float) {
+    alignas(32) float ret[8];
+    asm volatile(
+            "xvxor.v $xr0, $xr0, $xr0\n"
+            "xvxor.v $xr1, $xr1, $xr1\n"
+            "xvxor.v $xr2, $xr2, $xr2\n"
+            "xvxor.v $xr3, $xr3, $xr3\n"
+            "xvxor.v $xr4, $xr4, $xr4\n"
+            "xvxor.v $xr5, $xr5, $xr5\n"
+            "xvxor.v $xr6, $xr6, $xr6\n"
+            "xvxor.v $xr7, $xr7, $xr7\n"
+            "1:\n" LOAD4(a, 8, 9, 10, 11)
+            "xvld   $xr12, %[a], 128\n"
+            "xvld   $xr13, %[a], 160\n"
+            "xvld   $xr14, %[a], 192\n"
+            "xvld   $xr15, %[a], 224\n"
+            "xvfadd.s $xr0, $xr0, $xr8\n"
+            "xvfadd.s $xr1, $xr1, $xr9\n"
+            "xvfadd.s $xr2, $xr2, $xr10\n"
+            "xvfadd.s $xr3, $xr3, $xr11\n"
+            "xvfadd.s $xr4, $xr4, $xr12\n"
+            "xvfadd.s $xr5, $xr5, $xr13\n"
+            "xvfadd.s $xr6, $xr6, $xr14\n"
+            "xvfadd.s $xr7, $xr7, $xr15\n"
+            "addi.d  %[a], %[a], 256\n"
+            "addi.d  %[n], %[n], -64\n"
+            "bnez    %[n], 1b\n"
+            "xvfadd.s $xr0, $xr0, $xr1\n"
+            "xvfadd.s $xr2, $xr2, $xr3\n"
+            "xvfadd.s $xr4, $xr4, $xr5\n"
+            "xvfadd.s $xr6, $xr6, $xr7\n"
+            "xvfadd.s $xr0, $xr0, $xr2\n"
+            "xvfadd.s $xr4, $xr4, $xr6\n"
+            "xvfadd.s $xr0, $xr0, $xr4\n"
+            "xvst $xr0, %[ret], 0\n"
+            : [a] "+r"(a), [n] "+r"(n)
+            : [ret] "r"(ret)
+            : CLOBBERS, "$f9", "$f10", "$f11", "$f12", "$f13", "$f14",
+              "$f15");
+    float sum = 0;
+    for (size_t i = 0; i < 8; i++) {
+        sum += ret[i];
+    }
+    return sum;
+}
+
+float write_lasx(float* a, const float*, const float*, size_t n, float s) {
+    asm volatile("xvldrepl.w $xr8, %[s], 0\n"
+                 "1:\n" STORE4(a, 8, 8, 8, 8) NEXT(a) LOOP_END
+                 : [a] "+r"(a), [n] "+r"(n)
+                 : [s] "r"(&s)
+                 : CLOBBERS);
+    return 0;
+}
+
+float copy_lasx(float* a, const float* b, const float*, size_t n, float) {
+    asm volatile("1:\n" LOAD4(b, 0, 1, 2, 3) STORE4(a, 0, 1, 2, 3) NEXT(a)
+                         NEXT(b) LOOP_END
+                 : [a] "+r"(a), [b] "+r"(b), [n] "+r"(n)
+                 :
+                 : CLOBBERS);
+    return 0;
+}
+
+float scale_lasx(float* a, const float* b, const float*, size_t n, float s) {
+    asm volatile("xvldrepl.w $xr8, %[s], 0\n"
+                 "1:\n" LOAD4(b, 0, 1, 2, 3)
+                 "xvfmul.s $xr0, $xr0, $xr8\n"
+                 "xvfmul.s $xr1, $xr1, $xr8\n"
+                 "xvfmul.s $xr2, $xr2, $xr8\n"
+                 "xvfmul.s $xr3, $xr3, $xr8\n" STORE4(a, 0, 1, 2, 3) NEXT(a)
+                         NEXT(b) LOOP_END
+                 : [a] "+r"(a), [b] "+r"(b), [n] "+r"(n)
+                 : [s] "r"(&s)
+                 : CLOBBERS);
+    return 0;
+}
+
+float add_lasx(float* a, const float* b, const float* c, size_t n, float) {
+    asm volatile("1:\n" LOAD4(b, 0, 1, 2, 3) LOAD4(c, 4, 5, 6, 7)
+                 "xvfadd.s $xr0, $xr0, $xr4\n"
+                 "xvfadd.s $xr1, $xr1, $xr5\n"
+                 "xvfadd.s $xr2, $xr2, $xr6\n"
+                 "xvfadd.s $xr3, $xr3, $xr7\n" STORE4(a, 0, 1, 2, 3) NEXT(a)
+                         NEXT(b) NEXT(c) LOOP_END
+                 : [a] "+r"(a), [b] "+r"(b), [c] "+r"(c), [n] "+r"(n)
+                 :
+                 : CLOBBERS);
+    return 0;
+}
+
+float triad_lasx(float* a, const float* b, const float* c, size_t n,
+                 float s) {
+    asm volatile("xvldrepl.w $xr8, %[s], 0\n"
+                 "1:\n" LOAD4(b, 0, 1, 2, 3) LOAD4(c, 4, 5, 6, 7)
+                 "xvfmadd.s $xr0, $xr4, $xr8, $xr0\n"
+                 "xvfmadd.s $xr1, $xr5, $xr8, $xr1\n"
+                 "xvfmadd.s $xr2, $xr6, $xr8, $xr2\n"
+                 "xvfmadd.s $xr3, $xr7, $xr8, $xr3\n" STORE4(a, 0, 1, 2, 3)
+                         NEXT(a) NEXT(b) NEXT(c) LOOP_END
+                 : [a] "+r"(a), [b] "+r"(b), [c] "+r"(c), [n] "+r"(n)
+                 : [s] "r"(&s)
+                 : CLOBBERS);
+    return 0;
+}
+
+bool lasx_supported() {
+    return is_supported(SIMDType::LASX);
+}
+}  // namespace
+
+std::vector<StreamKernels> megpeak::get_stream_kernels() {
+    return {{"lasx",
+             lasx_supported,
+             {read_lasx, write_lasx, copy_lasx, scale_lasx, add_lasx,
+              triad_lasx},
+             {}}};
+}
+#endif
+
+// vim: syntax=cpp.doxygen
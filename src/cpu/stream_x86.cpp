@@ -0,0 +1,158 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/cpu/stream.h"
+
+#if MEGPEAK_X86
+#include <immintrin.h>
+
+#include "src/cpu/common.h"
+#include "src/cpu/x86_utils.h"
+
+using namespace megpeak;
+
+namespace {
+//! the write kernels handle 4 vectors of an array per iteration, the vector
+//! operations are passed as macros, as the kernels of each isa need its
+//! target attribute to inline the intrinsics
+// clang-format off
+#define READ_SUM_DECL(i, vec, set1) vec sum##i = set1(0.f);
+#define READ_SUM_ADD(i, add, load, width) \
+    sum##i = add(sum##i, load(a + k + i * width));
+#define READ_SUM_FOLD(i, add) total = add(total, sum##i);
+
+//! the read kernel keeps READ_CHAINS independent sums, the add latency
+//! times the loads per cycle of 2 or 3 load ports, so that the adds never
+//! throttle the loads
+#define READ_CHAINS 16
+#define READ_KERNEL(func, simd, vec, width, load, store, add, set1)           \
+    MEGPEAK_ATTRIBUTE_TARGET(simd)                                           \
+    float func(float* a, const float*, const float*, size_t n, float) {      \
+        UNROLL_CALL(READ_CHAINS, READ_SUM_DECL, vec, set1)                   \
+        for (size_t k = 0; k < n; k += READ_CHAINS * width) {                \
+            UNROLL_CALL(READ_CHAINS, READ_SUM_ADD, add, load, width)         \
+        }                                                                    \
+        vec total = set1(0.f);                                               \
+        UNROLL_CALL(READ_CHAINS, READ_SUM_FOLD, add)                         \
+        alignas(64) float ret[width];                                        \
+        store(ret, total);                                                   \
+        float sum = 0;                                                       \
+        for (size_t i = 0; i < width; i++) {                                 \
+            sum += ret[i];                                                   \
+        }                                                                    \
+        return sum;                                                          \
+    }
+
+//! the kernels which write a, with the regular or the streaming store, the
+//! fence makes the streaming stores visible before the timer stops
+#define WRITE_KERNELS(suffix, simd, vec, width, load, store, fence, add, mul, \
+                      set1)                                                  \
+    MEGPEAK_ATTRIBUTE_TARGET(simd)                                           \
+    float write_##suffix(float* a, const float*, const float*, size_t n,     \
+                         float s) {                                          \
+        vec vs = set1(s);                                                    \
+        for (size_t i = 0; i < n; i += 4 * width) {                          \
+            for (size_t j = 0; j < 4 * width; j += width) {                  \
+                store(a + i + j, vs);                                        \
+            }                                                                \
+        }                                                                    \
+        fence;                                                               \
+        return 0;                                                            \
+    }                                                                        \
+    MEGPEAK_ATTRIBUTE_TARGET(simd)                                           \
+    float copy_##suffix(float* a, const float* b, const float*, size_t n,    \
+                        float) {                                             \
+        for (size_t i = 0; i < n; i += 4 * width) {                          \
+            for (size_t j = 0; j < 4 * width; j += width) {                  \
+                store(a + i + j, load(b + i + j));                           \
+            }                                                                \
+        }                                                                    \
+        fence;                                                               \
+        return 0;                                                            \
+    }                                                                        \
+    MEGPEAK_ATTRIBUTE_TARGET(simd)                                           \
+    float scale_##suffix(float* a, const float* b, const float*, size_t n,   \
+                         float s) {                                          \
+        vec vs = set1(s);                                                    \
+        for (size_t i = 0; i < n; i += 4 * width) {                          \
+            for (size_t j = 0; j < 4 * width; j += width) {                  \
+                store(a + i + j, mul(vs, load(b + i + j)));                  \
+            }                                                                \
+        }                                                                    \
+        fence;                                                               \
+        return 0;                                                            \
+    }                                                                        \
+    MEGPEAK_ATTRIBUTE_TARGET(simd)                                           \
+    float add_##suffix(float* a, const float* b, const float* c, size_t n,   \
+                       float) {                                              \
+        for (size_t i = 0; i < n; i += 4 * width) {                          \
+            for (size_t j = 0; j < 4 * width; j += width) {                  \
+                store(a + i + j, add(load(b + i + j), load(c + i + j)));     \
+            }                                                                \
+        }                                                                    \
+        fence;                                                               \
+        return 0;                                                            \
+    }                                                                        \
+    MEGPEAK_ATTRIBUTE_TARGET(simd)                                           \
+    float triad_##suffix(float* a, const float* b, const float* c, size_t n, \
+                         float s) {                                          \
+        vec vs = set1(s);                                                    \
+        for (size_t i = 0; i < n; i += 4 * width) {                          \
+            for (size_t j = 0; j < 4 * width; j += width) {                  \
+                store(a + i + j,                                             \
+                      add(load(b + i + j), mul(vs, load(c + i + j))));       \
+            }                                                                \
+        }                                                                    \
+        fence;                                                               \
+        return 0;                                                            \
+    }
+// clang-format on
+
+READ_KERNEL(read_avx2, "avx2", __m256, 8, _mm256_load_ps, _mm256_store_ps,
+            _mm256_add_ps, _mm256_set1_ps)
+WRITE_KERNELS(avx2, "avx2", __m256, 8, _mm256_load_ps, _mm256_store_ps, ,
+              _mm256_add_ps, _mm256_mul_ps, _mm256_set1_ps)
+WRITE_KERNELS(nt_avx2, "avx2", __m256, 8, _mm256_load_ps, _mm256_stream_ps,
+              _mm_sfence(), _mm256_add_ps, _mm256_mul_ps, _mm256_set1_ps)
+
+READ_KERNEL(read_avx512, "avx512f", __m512, 16, _mm512_load_ps,
+            _mm512_store_ps, _mm512_add_ps, _mm512_set1_ps)
+WRITE_KERNELS(avx512, "avx512f", __m512, 16, _mm512_load_ps, _mm512_store_ps,
+              , _mm512_add_ps, _mm512_mul_ps, _mm512_set1_ps)
+WRITE_KERNELS(nt_avx512, "avx512f", __m512, 16, _mm512_load_ps,
+              _mm512_stream_ps, _mm_sfence(), _mm512_add_ps, _mm512_mul_ps,
+              _mm512_set1_ps)
+
+bool avx2_supported() {
+    return is_supported(SIMDType::AVX2);
+}
+bool avx512_supported() {
+    return is_supported(SIMDType::AVX512);
+}
+}  // namespace
+
+std::vector<StreamKernels> megpeak::get_stream_kernels() {
+    return {{"avx2",
+             avx2_supported,
+             {read_avx2, write_avx2, copy_avx2, scale_avx2, add_avx2,
+              triad_avx2},
+             {nullptr, write_nt_avx2, copy_nt_avx2, scale_nt_avx2,
+              add_nt_avx2, triad_nt_avx2}},
+            {"avx512",
+             avx512_supported,
+             {read_avx512, write_avx512, copy_avx512, scale_avx512,
+              add_avx512, triad_avx512},
+             {nullptr, write_nt_avx512, copy_nt_avx512, scale_nt_avx512,
+              add_nt_avx512, triad_nt_avx512}}};
+}
+#endif
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,182 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/cpu/topology.h"
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <sstream>
+
+#include "src/backend.h"
+
+using namespace megpeak;
+
+size_t megpeak::get_cpu_count() {
+    size_t cpu_num = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpu_num;
+}
+
+int megpeak::cpu_set_affinity(int dev_id) {
+#if defined(__APPLE__)
+#pragma message("set_cpu_affinity not enabled on apple platform")
+    printf("WARNING: cpu core affinity is not usable in apple os\n");
+    return 0;
+#else
+    cpu_set_t cst;
+    CPU_ZERO(&cst);
+    CPU_SET(dev_id, &cst);
+    return sched_setaffinity(0, sizeof(cst), &cst);
+#endif
+}
+
+namespace {
+//! the first line of a sysfs file, empty if it can not be read
+std::string read_sysfs(const std::string& path) {
+    char buf[256] = {};
+    FILE* file = fopen(path.c_str(), "r");
+    if (!file) {
+        return "";
+    }
+    if (!fgets(buf, sizeof(buf), file)) {
+        buf[0] = '\0';
+    }
+    fclose(file);
+    std::string ret = buf;
+    while (!ret.empty() && (ret.back() == '\n' || ret.back() == ' ')) {
+        ret.pop_back();
+    }
+    return ret;
+}
+
+int read_sysfs_int(const std::string& path) {
+    auto value = read_sysfs(path);
+    return value.empty() ? -1 : atoi(value.c_str());
+}
+}  // namespace
+
+std::vector<size_t> megpeak::get_online_cpus() {
+    auto online = read_sysfs("/sys/devices/system/cpu/online");
+    if (!online.empty()) {
+        return parse_cpu_list(online);
+    }
+    std::vector<size_t> ret;
+    for (size_t cpu = 0; cpu < get_cpu_count(); cpu++) {
+        ret.push_back(cpu);
+    }
+    return ret;
+}
+
+std::vector<size_t> megpeak::parse_cpu_list(const std::string& list) {
+    std::vector<size_t> ret;
+    std::stringstream ranges(list);
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+        if (range.empty() || range == "\n") {
+            continue;
+        }
+        char* end = nullptr;
+        size_t first = strtoul(range.c_str(), &end, 10);
+        size_t last = first;
+        if (*end == '-') {
+            last = strtoul(end + 1, &end, 10);
+        }
+        megpeak_assert(end != range.c_str() && (*end == '\0' || *end == '\n') &&
+                               first <= last,
+                       "invalid cpu list \"%s\"", list.c_str());
+        for (size_t cpu = first; cpu <= last; cpu++) {
+            ret.push_back(cpu);
+        }
+    }
+    return ret;
+}
+
+std::string megpeak::format_cpu_list(const std::vector<size_t>& cpus) {
+    std::string ret;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+            j++;
+        }
+        ret += (ret.empty() ? "" : ",") + std::to_string(cpus[i]);
+        if (j > i) {
+            ret += "-" + std::to_string(cpus[j]);
+        }
+        i = j + 1;
+    }
+    return ret;
+}
+
+size_t megpeak::get_current_cpu() {
+#if defined(__linux__)
+    int cpu = sched_getcpu();
+    return cpu < 0 ? 0 : cpu;
+#else
+    return 0;
+#endif
+}
+
+std::vector<CacheInfo> megpeak::read_cache_info(size_t cpu) {
+    std::vector<CacheInfo> ret;
+    std::string dir =
+            "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cache";
+    for (size_t index = 0;; index++) {
+        std::string path = dir + "/index" + std::to_string(index);
+        auto type = read_sysfs(path + "/type");
+        if (type.empty()) {
+            break;
+        }
+        if (type == "Instruction") {
+            continue;
+        }
+        //! e.g. 48K, the kernel prints the size in KiB
+        auto size = read_sysfs(path + "/size");
+        char* end = nullptr;
+        size_t bytes = strtoul(size.c_str(), &end, 10);
+        if (*end == 'K') {
+            bytes *= 1024;
+        } else if (*end == 'M') {
+            bytes *= 1024 * 1024;
+        }
+        int level = read_sysfs_int(path + "/level");
+        if (level > 0 && bytes) {
+            ret.push_back({level, bytes});
+        }
+    }
+    std::sort(ret.begin(), ret.end(),
+              [](const CacheInfo& lhs, const CacheInfo& rhs) {
+                  return lhs.level < rhs.level;
+              });
+    return ret;
+}
+
+CoreInfo megpeak::read_core_info(size_t cpu) {
+    CoreInfo ret;
+    ret.cpu = cpu;
+    std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    ret.package_id = read_sysfs_int(dir + "/topology/physical_package_id");
+    ret.cluster_id = read_sysfs_int(dir + "/topology/cluster_id");
+    ret.core_id = read_sysfs_int(dir + "/topology/core_id");
+    auto siblings = read_sysfs(dir + "/topology/thread_siblings_list");
+    if (!siblings.empty()) {
+        ret.siblings = parse_cpu_list(siblings);
+    }
+    //! in kHz
+    int max_freq = read_sysfs_int(dir + "/cpufreq/cpuinfo_max_freq");
+    int min_freq = read_sysfs_int(dir + "/cpufreq/cpuinfo_min_freq");
+    ret.max_freq = max_freq > 0 ? max_freq / 1e3 : 0;
+    ret.min_freq = min_freq > 0 ? min_freq / 1e3 : 0;
+    return ret;
+}
+
+// vim: syntax=cpp.doxygen
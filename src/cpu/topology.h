@@ -0,0 +1,76 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace megpeak {
+
+//! number of online cores
+size_t get_cpu_count();
+
+//! ids of the online cores, from sysfs if available, else 0 ... count - 1
+std::vector<size_t> get_online_cpus();
+
+//! pin the calling thread to the core, -1 on failure
+int cpu_set_affinity(int dev_id);
+
+/**
+ * \brief parse a cpu list like "0-3,8,10-11"
+ *
+ * the format of --cores and of the sysfs cpu lists, an invalid list is a
+ * fatal error.
+ */
+std::vector<size_t> parse_cpu_list(const std::string& list);
+
+//! the reverse of parse_cpu_list(), e.g. "0-3,8"
+std::string format_cpu_list(const std::vector<size_t>& cpus);
+
+//! what sysfs tells about a core, -1 or empty when a file is missing
+struct CoreInfo {
+    size_t cpu = 0;
+    int package_id = -1;
+    //! the cluster of the arm cores and of the x86 e-core modules
+    int cluster_id = -1;
+    int core_id = -1;
+    //! the smt threads of the core, including itself
+    std::vector<size_t> siblings;
+    //! cpufreq limits in MHz, 0 without cpufreq
+    double max_freq = 0;
+    double min_freq = 0;
+};
+
+//! read /sys/devices/system/cpu/cpu<cpu>/topology and cpufreq
+CoreInfo read_core_info(size_t cpu);
+
+//! the core the calling thread runs on, 0 if it can not be told
+size_t get_current_cpu();
+
+//! a data or unified cache of a core
+struct CacheInfo {
+    int level = 0;
+    size_t bytes = 0;
+};
+
+/**
+ * \brief the data and unified caches of a core from
+ * /sys/devices/system/cpu/cpu<cpu>/cache/index*, by ascending level
+ *
+ * the size of a shared cache is the whole cache, not the share of the core.
+ * Empty without sysfs.
+ */
+std::vector<CacheInfo> read_cache_info(size_t cpu);
+
+}  // namespace megpeak
+
+// vim: syntax=cpp.doxygen
@@ -10,6 +10,7 @@
  */
 
 #include "src/cpu/common.h"
+#include "src/cpu/registry.h"
 #include "src/cpu/x86_utils.h"
 
 #if MEGPEAK_X86
@@ -22,39 +23,58 @@
 // clang-format off
 #define THROUGHPUT(cb, func, simd)                                 \
     MEGPEAK_ATTRIBUTE_TARGET(simd)                                 \
-    static int func##_throughput() {                               \
+    static size_t func##_throughput(size_t runs) {                 \
         asm volatile(                                              \
         UNROLL_CALL(10, eor)                                       \
-        "movl %[RUNS], %%eax \n"                                   \
+        "mov %[RUNS], %%rax \n"                                    \
         "1:\n"                                                     \
         UNROLL_CALL(10, cb)                                        \
-        "sub  $0x01, %%eax\n"                                      \
+        "sub  $0x01, %%rax\n"                                      \
         "jne 1b \n"                                                \
         :                                                          \
-        :[RUNS] "r"(megpeak::RUNS * 100)                           \
+        :[RUNS] "r"(runs)                                          \
         : "%ymm0", "%ymm1", "%ymm2", "%ymm3", "%ymm4", "%ymm5",    \
-           "%ymm6", "%ymm7", "%ymm8", "%ymm9", "%eax", "cc");      \
-        return megpeak::RUNS * 100 * 10;                           \
+           "%ymm6", "%ymm7", "%ymm8", "%ymm9", "%rax", "cc");      \
+        return runs * 10;                                          \
     }
 
-#define LATENCY(cb, func, simd)          \
-    MEGPEAK_ATTRIBUTE_TARGET(simd)       \
-    static int func##_latency() {        \
-        asm volatile(                    \
-        "vxorpd %%ymm0, %%ymm0, %%ymm0\n"\
-        "movl %[RUNS], %%eax \n"         \
-        "1:\n"                           \
-        UNROLL_CALL(10, cb)              \
-        "sub  $0x01, %%eax\n"            \
-        "jne 1b \n"                      \
-        :                                \
-        :[RUNS] "r"(megpeak::RUNS * 100) \
-        : "%ymm0", "%eax", "cc");        \
-        return megpeak::RUNS * 100 * 10; \
+#define LATENCY(cb, func, simd)                 \
+    MEGPEAK_ATTRIBUTE_TARGET(simd)              \
+    static size_t func##_latency(size_t runs) { \
+        asm volatile(                           \
+        "vxorpd %%ymm0, %%ymm0, %%ymm0\n"       \
+        "mov %[RUNS], %%rax \n"                 \
+        "1:\n"                                  \
+        UNROLL_CALL(10, cb)                     \
+        "sub  $0x01, %%rax\n"                   \
+        "jne 1b \n"                             \
+        :                                       \
+        :[RUNS] "r"(runs)                       \
+        : "%ymm0", "%rax", "cc");               \
+        return runs * 10;                       \
+    }
+
+#define ILP(cb, func, chains, simd)                                \
+    MEGPEAK_ATTRIBUTE_TARGET(simd)                                 \
+    static size_t func##_chains##chains(size_t runs) {             \
+        asm volatile(                                              \
+        UNROLL_CALL(chains, eor)                                   \
+        "mov %[RUNS], %%rax \n"                                    \
+        "1:\n"                                                     \
+        ILP_BODY(chains, cb)                                       \
+        "sub  $0x01, %%rax\n"                                      \
+        "jne 1b \n"                                                \
+        :                                                          \
+        :[RUNS] "r"(runs)                                          \
+        : "%ymm0", "%ymm1", "%ymm2", "%ymm3", "%ymm4", "%ymm5",    \
+           "%ymm6", "%ymm7", "%ymm8", "%ymm9", "%ymm10", "%ymm11", \
+           "%ymm12", "%ymm13", "%ymm14", "%ymm15", "%rax", "cc");  \
+        return runs * chains * ILP_CHAIN_LENGTH;                   \
     }
 // clang-format on
 #define cb(i) "vfmadd132ps %%ymm" #i ", %%ymm" #i ", %%ymm" #i "\n"
 THROUGHPUT(cb, vfmadd132ps, "avx2")
+ILP_SWEEP(cb, vfmadd132ps, "avx2")
 #undef cb
 #define cb(i) "vfmadd132ps %%ymm0, %%ymm0, %%ymm0\n"
 LATENCY(cb, vfmadd132ps, "avx2")
@@ -62,6 +82,7 @@ LATENCY(cb, vfmadd132ps, "avx2")
 
 #define cb(i) "vfmadd132pd %%ymm" #i ", %%ymm" #i ", %%ymm" #i "\n"
 THROUGHPUT(cb, vfmadd132pd, "avx2")
+ILP_SWEEP(cb, vfmadd132pd, "avx2")
 #undef cb
 #define cb(i) "vfmadd132pd %%ymm0, %%ymm0, %%ymm0\n"
 LATENCY(cb, vfmadd132pd, "avx")
@@ -69,6 +90,7 @@ LATENCY(cb, vfmadd132pd, "avx")
 
 #define cb(i) "vpmaddwd %%ymm" #i ", %%ymm" #i ", %%ymm" #i "\n"
 THROUGHPUT(cb, vpmaddwd, "avx2")
+ILP_SWEEP(cb, vpmaddwd, "avx2")
 #undef cb
 #define cb(i) "vpmaddwd %%ymm0, %%ymm0, %%ymm0\n"
 LATENCY(cb, vpmaddwd, "avx2")
@@ -76,6 +98,7 @@ LATENCY(cb, vpmaddwd, "avx2")
 
 #define cb(i) "vpaddd %%ymm" #i ", %%ymm" #i ", %%ymm" #i "\n"
 THROUGHPUT(cb, vpaddd, "avx2")
+ILP_SWEEP(cb, vpaddd, "avx2")
 #undef cb
 #define cb(i) "vpaddd %%ymm0, %%ymm0, %%ymm0\n"
 LATENCY(cb, vpaddd, "avx2")
@@ -114,6 +137,44 @@ THROUGHPUT(cb, vpmaddwd_vpaddd, "avx2")
 LATENCY(cb, vpmaddwd_vpaddd, "avx2")
 #undef cb
 
+//! vector loads from the l1 cache, the latency is the load-to-use of a
+//! pointer chasing mov, the vector loads have no address dependency
+// clang-format off
+#define cb(i) "vmovups " #i "*32(%[a_ptr]), %%ymm" #i "\n"
+MEGPEAK_ATTRIBUTE_TARGET("avx")
+static size_t vmovups_load_throughput(size_t runs) {
+    const float* a_ptr = reinterpret_cast<float*>(get_mem_align64());
+    asm volatile(
+    "mov %[RUNS], %%rax \n"
+    "1:\n"
+    UNROLL_CALL(10, cb)
+    "sub  $0x01, %%rax\n"
+    "jne 1b \n"
+    :
+    :[RUNS] "r"(runs), [a_ptr] "r"(a_ptr)
+    : "%ymm0", "%ymm1", "%ymm2", "%ymm3", "%ymm4", "%ymm5",
+       "%ymm6", "%ymm7", "%ymm8", "%ymm9", "%rax", "cc", "memory");
+    return runs * 10;
+}
+#undef cb
+#define cb(i) "mov (%[ptr]), %[ptr]\n"
+static size_t vmovups_load_latency(size_t runs) {
+    void** ptr = reinterpret_cast<void**>(get_mem_align64());
+    *ptr = ptr;
+    asm volatile(
+    "mov %[RUNS], %%rax \n"
+    "1:\n"
+    UNROLL_CALL(10, cb)
+    "sub  $0x01, %%rax\n"
+    "jne 1b \n"
+    :[ptr] "+r"(ptr)
+    :[RUNS] "r"(runs)
+    : "%rax", "cc", "memory");
+    return runs * 10;
+}
+#undef cb
+// clang-format on
+
 #define cb(i) "vpmaddwd %%zmm" #i ", %%zmm" #i ", %%zmm" #i "\n"
 THROUGHPUT(cb, vpmaddwd_512, "avx512bw")
 #undef cb
@@ -130,6 +191,7 @@ LATENCY(cb, vpaddd_512, "avx512f")
 
 #define cb(i) "vfmadd132ps %%zmm" #i ", %%zmm" #i ", %%zmm" #i "\n"
 THROUGHPUT(cb, vfmadd132ps_512, "avx512f")
+ILP_SWEEP(cb, vfmadd132ps_512, "avx512f")
 #undef cb
 #define cb(i) "vfmadd132ps %%zmm0, %%zmm0, %%zmm0\n"
 LATENCY(cb, vfmadd132ps_512, "avx512f")
@@ -146,54 +208,77 @@ LATENCY(cb, vpdpbusd, "avx512vnni")
 
 #endif
 
-void megpeak::x86_avx() {
-    if (is_supported(SIMDType::FMA) && is_supported(SIMDType::AVX)) {
-        //! warmup
-        for (size_t i = 0; i < 10; i++) {
-            vfmadd132ps_throughput();
-        }
-        //! fma is 256 width, mul + add = 2 ops
-        benchmark(vfmadd132ps_throughput, vfmadd132ps_latency,
-                  "vfmadd132ps_avx", 8 * 2);
-        benchmark(vfmadd132pd_throughput, vfmadd132pd_latency,
-                  "vfmadd132pd_avx", 4 * 2);
-    }
-    if (is_supported(SIMDType::AVX2)) {
-        //! warmup
-        for (size_t i = 0; i < 10; i++) {
-            vpmaddwd_throughput();
-        }
-        benchmark(vpmaddwd_throughput, vpmaddwd_latency, "vpmaddwd_avx2",
-                  16 + 8);
-        benchmark(vpaddd_throughput, vpaddd_latency, "vpaddd_avx2", 8);
-        benchmark(vpand_throughput, vpand_latency, "vpand_avx2", 8);
-        benchmark(vpmaddwd_vpaddd_throughput, vpmaddwd_vpaddd_latency,
-                  "vpmaddwd_vpaddd_avx2", 16 + 8 + 8);
-
-        benchmark(vpackssdw_throughput, vpackssdw_latency, "vpackssdw_avx2",
-                  16);
-        benchmark(vpacksswb_throughput, vpacksswb_latency, "vpacksswb_avx2",
-                  32);
-    }
-    if (is_supported(SIMDType::AVX512)) {
-        //! warmup
-        for (size_t i = 0; i < 10; i++) {
-            vpmaddwd_512_throughput();
-        }
-        benchmark(vpmaddwd_512_throughput, vpmaddwd_512_latency, "vpmaddwd_512",
-                  32 + 16);
-        benchmark(vpaddd_512_throughput, vpaddd_512_latency, "vpaddd_512", 16);
-    }
+using namespace megpeak;
 
-    if (is_supported(SIMDType::AVX512)) {
-        benchmark(vfmadd132ps_512_throughput, vfmadd132ps_512_latency,
-                  "vfmadd132ps_512", 16 * 2);
-    }
+namespace {
+bool avx_supported() {
+    return is_supported(SIMDType::AVX);
+}
+bool fma_supported() {
+    return is_supported(SIMDType::FMA) && is_supported(SIMDType::AVX);
+}
+bool avx2_supported() {
+    return is_supported(SIMDType::AVX2);
+}
+bool avx512_supported() {
+    return is_supported(SIMDType::AVX512);
+}
+bool vnni_supported() {
+    return is_supported(SIMDType::VNNI);
+}
+}  // namespace
+
+//! fma is 256 width, mul + add = 2 ops
+MEGPEAK_REGISTER_BENCHMARK(x86_avx, vfmadd132ps, "vfmadd132ps_avx", "fma",
+                           fma_supported, 8 * 2, "fp32,fma")
+MEGPEAK_REGISTER_BENCHMARK(x86_avx, vfmadd132pd, "vfmadd132pd_avx", "fma",
+                           fma_supported, 4 * 2, "fp64,fma")
+MEGPEAK_REGISTER_BENCHMARK(x86_avx, vpmaddwd, "vpmaddwd_avx2", "avx2",
+                           avx2_supported, 16 + 8, "int16")
+MEGPEAK_REGISTER_BENCHMARK(x86_avx, vpaddd, "vpaddd_avx2", "avx2",
+                           avx2_supported, 8, "int32")
+MEGPEAK_REGISTER_BENCHMARK(x86_avx, vpand, "vpand_avx2", "avx2",
+                           avx2_supported, 8, "logic")
+MEGPEAK_REGISTER_BENCHMARK(x86_avx, vpmaddwd_vpaddd, "vpmaddwd_vpaddd_avx2",
+                           "avx2", avx2_supported, 16 + 8 + 8, "int16,mixed")
+//! loads do no flops, extended so that the default output keeps its
+//! GFlops table, it is for --smt, --pairs and --filter
+MEGPEAK_REGISTER_BENCHMARK(x86_avx, vmovups_load, "vmovups_load_avx", "avx",
+                           avx_supported, 0, "load_store,extended",
+                           "latency is the load-to-use of a mov pointer chase")
+MEGPEAK_REGISTER_BENCHMARK(x86_avx, vpackssdw, "vpackssdw_avx2", "avx2",
+                           avx2_supported, 16, "shuffle")
+MEGPEAK_REGISTER_BENCHMARK(x86_avx, vpacksswb, "vpacksswb_avx2", "avx2",
+                           avx2_supported, 32, "shuffle")
+MEGPEAK_REGISTER_BENCHMARK(x86_avx, vpmaddwd_512, "vpmaddwd_512", "avx512",
+                           avx512_supported, 32 + 16, "int16")
+MEGPEAK_REGISTER_BENCHMARK(x86_avx, vpaddd_512, "vpaddd_512", "avx512",
+                           avx512_supported, 16, "int32")
+MEGPEAK_REGISTER_BENCHMARK(x86_avx, vfmadd132ps_512, "vfmadd132ps_512",
+                           "avx512", avx512_supported, 16 * 2, "fp32,fma")
 #if __AVX512VNNI__
-    if (is_supported(SIMDType::VNNI)) {
-        benchmark(vpdpbusd_throughput, vpdpbusd_latency, "vpdpbusd_vnni", 112);
-    }
+MEGPEAK_REGISTER_BENCHMARK(x86_avx, vpdpbusd, "vpdpbusd_vnni", "avx512vnni",
+                           vnni_supported, 112, "int8")
 #endif
+
+MEGPEAK_REGISTER_ILP_SWEEP(x86_avx, vfmadd132ps, "vfmadd132ps_avx")
+MEGPEAK_REGISTER_ILP_SWEEP(x86_avx, vfmadd132pd, "vfmadd132pd_avx")
+MEGPEAK_REGISTER_ILP_SWEEP(x86_avx, vpmaddwd, "vpmaddwd_avx2")
+MEGPEAK_REGISTER_ILP_SWEEP(x86_avx, vpaddd, "vpaddd_avx2")
+MEGPEAK_REGISTER_ILP_SWEEP(x86_avx, vfmadd132ps_512, "vfmadd132ps_512")
+
+//! the jit has no evex encoding, the avx512 kernels are not paired
+MEGPEAK_REGISTER_MIX(x86_avx, vfmadd132ps, "vfmadd132ps_avx", "vfmadd132ps ymm")
+MEGPEAK_REGISTER_MIX(x86_avx, vfmadd132pd, "vfmadd132pd_avx", "vfmadd132pd ymm")
+MEGPEAK_REGISTER_MIX(x86_avx, vpmaddwd, "vpmaddwd_avx2", "vpmaddwd ymm")
+MEGPEAK_REGISTER_MIX(x86_avx, vpaddd, "vpaddd_avx2", "vpaddd ymm")
+MEGPEAK_REGISTER_MIX(x86_avx, vpand, "vpand_avx2", "vpand ymm")
+MEGPEAK_REGISTER_MIX(x86_avx, vmovups_load, "vmovups_load_avx", "vmovups load")
+MEGPEAK_REGISTER_MIX(x86_avx, vpackssdw, "vpackssdw_avx2", "vpackssdw ymm")
+MEGPEAK_REGISTER_MIX(x86_avx, vpacksswb, "vpacksswb_avx2", "vpacksswb ymm")
+
+void megpeak::x86_avx() {
+    run_benchmarks(select_benchmarks("x86_avx"));
 }
 #else
 void megpeak::x86_avx() {}
@@ -0,0 +1,453 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/cpu/jit.h"
+
+#if MEGPEAK_JIT && MEGPEAK_X86
+#include <string.h>
+#include <algorithm>
+
+#include "src/backend.h"
+#include "src/cpu/x86_utils.h"
+
+using namespace megpeak;
+
+namespace {
+enum class Form {
+    //! op dst, src1, src2/mem, src1 is encoded in vex.vvvv
+    NDS,
+    //! op dst, src/mem
+    UNARY,
+    //! load: op dst, mem, store: op mem, src
+    MOVE,
+};
+
+//! a vex encoded instruction, ref: intel sdm vol 2, 2.3 vex prefix
+struct VexInst {
+    const char* name;
+    //! implied prefix, 0: none, 1: 66, 2: F3, 3: F2
+    uint8_t pp;
+    //! opcode map, 1: 0F, 2: 0F38, 3: 0F3A
+    uint8_t map;
+    uint8_t opcode;
+    //! opcode of the store form of MOVE
+    uint8_t store_opcode;
+    uint8_t w;
+    Form form;
+    //! operations done by the 256 bits instruction, half of them for 128 bits
+    size_t flops;
+    SIMDType isa128;
+    SIMDType isa256;
+};
+
+constexpr SIMDType AVX = SIMDType::AVX, AVX2 = SIMDType::AVX2,
+                   FMA = SIMDType::FMA;
+
+// clang-format off
+const VexInst VEX_INSTS[] = {
+        {"vfmadd132ps", 1, 2, 0x98, 0, 0, Form::NDS, 16, FMA, FMA},
+        {"vfmadd213ps", 1, 2, 0xa8, 0, 0, Form::NDS, 16, FMA, FMA},
+        {"vfmadd231ps", 1, 2, 0xb8, 0, 0, Form::NDS, 16, FMA, FMA},
+        {"vfnmadd231ps", 1, 2, 0xbc, 0, 0, Form::NDS, 16, FMA, FMA},
+        {"vfmadd132pd", 1, 2, 0x98, 0, 1, Form::NDS, 8, FMA, FMA},
+        {"vfmadd213pd", 1, 2, 0xa8, 0, 1, Form::NDS, 8, FMA, FMA},
+        {"vfmadd231pd", 1, 2, 0xb8, 0, 1, Form::NDS, 8, FMA, FMA},
+        {"vaddps", 0, 1, 0x58, 0, 0, Form::NDS, 8, AVX, AVX},
+        {"vmulps", 0, 1, 0x59, 0, 0, Form::NDS, 8, AVX, AVX},
+        {"vsubps", 0, 1, 0x5c, 0, 0, Form::NDS, 8, AVX, AVX},
+        {"vminps", 0, 1, 0x5d, 0, 0, Form::NDS, 8, AVX, AVX},
+        {"vdivps", 0, 1, 0x5e, 0, 0, Form::NDS, 8, AVX, AVX},
+        {"vmaxps", 0, 1, 0x5f, 0, 0, Form::NDS, 8, AVX, AVX},
+        {"vandps", 0, 1, 0x54, 0, 0, Form::NDS, 8, AVX, AVX},
+        {"vxorps", 0, 1, 0x57, 0, 0, Form::NDS, 8, AVX, AVX},
+        {"vaddpd", 1, 1, 0x58, 0, 0, Form::NDS, 4, AVX, AVX},
+        {"vmulpd", 1, 1, 0x59, 0, 0, Form::NDS, 4, AVX, AVX},
+        {"vdivpd", 1, 1, 0x5e, 0, 0, Form::NDS, 4, AVX, AVX},
+        {"vsqrtps", 0, 1, 0x51, 0, 0, Form::UNARY, 8, AVX, AVX},
+        {"vrsqrtps", 0, 1, 0x52, 0, 0, Form::UNARY, 8, AVX, AVX},
+        {"vrcpps", 0, 1, 0x53, 0, 0, Form::UNARY, 8, AVX, AVX},
+        {"vsqrtpd", 1, 1, 0x51, 0, 0, Form::UNARY, 4, AVX, AVX},
+        {"vcvtdq2ps", 0, 1, 0x5b, 0, 0, Form::UNARY, 8, AVX, AVX},
+        {"vcvtps2dq", 1, 1, 0x5b, 0, 0, Form::UNARY, 8, AVX, AVX},
+        {"vcvttps2dq", 2, 1, 0x5b, 0, 0, Form::UNARY, 8, AVX, AVX},
+        {"vpaddb", 1, 1, 0xfc, 0, 0, Form::NDS, 32, AVX, AVX2},
+        {"vpaddw", 1, 1, 0xfd, 0, 0, Form::NDS, 16, AVX, AVX2},
+        {"vpaddd", 1, 1, 0xfe, 0, 0, Form::NDS, 8, AVX, AVX2},
+        {"vpaddq", 1, 1, 0xd4, 0, 0, Form::NDS, 4, AVX, AVX2},
+        {"vpsubd", 1, 1, 0xfa, 0, 0, Form::NDS, 8, AVX, AVX2},
+        {"vpmullw", 1, 1, 0xd5, 0, 0, Form::NDS, 16, AVX, AVX2},
+        {"vpmaddwd", 1, 1, 0xf5, 0, 0, Form::NDS, 16 + 8, AVX, AVX2},
+        {"vpsadbw", 1, 1, 0xf6, 0, 0, Form::NDS, 32, AVX, AVX2},
+        {"vpavgb", 1, 1, 0xe0, 0, 0, Form::NDS, 32, AVX, AVX2},
+        {"vpmaxsw", 1, 1, 0xee, 0, 0, Form::NDS, 16, AVX, AVX2},
+        {"vpand", 1, 1, 0xdb, 0, 0, Form::NDS, 8, AVX, AVX2},
+        {"vpor", 1, 1, 0xeb, 0, 0, Form::NDS, 8, AVX, AVX2},
+        {"vpxor", 1, 1, 0xef, 0, 0, Form::NDS, 8, AVX, AVX2},
+        {"vpunpcklbw", 1, 1, 0x60, 0, 0, Form::NDS, 32, AVX, AVX2},
+        {"vpacksswb", 1, 1, 0x63, 0, 0, Form::NDS, 32, AVX, AVX2},
+        {"vpackssdw", 1, 1, 0x6b, 0, 0, Form::NDS, 16, AVX, AVX2},
+        {"vpshufb", 1, 2, 0x00, 0, 0, Form::NDS, 32, AVX, AVX2},
+        {"vpmaddubsw", 1, 2, 0x04, 0, 0, Form::NDS, 32 + 16, AVX, AVX2},
+        {"vpmulld", 1, 2, 0x40, 0, 0, Form::NDS, 8, AVX, AVX2},
+        {"vpabsd", 1, 2, 0x1e, 0, 0, Form::UNARY, 8, AVX, AVX2},
+        {"vbroadcastss", 1, 2, 0x18, 0, 0, Form::UNARY, 0, AVX2, AVX2},
+        {"vpbroadcastd", 1, 2, 0x58, 0, 0, Form::UNARY, 0, AVX2, AVX2},
+        {"vmovups", 0, 1, 0x10, 0x11, 0, Form::MOVE, 0, AVX, AVX},
+        {"vmovaps", 0, 1, 0x28, 0x29, 0, Form::MOVE, 0, AVX, AVX},
+        {"vmovupd", 1, 1, 0x10, 0x11, 0, Form::MOVE, 0, AVX, AVX},
+        {"vmovdqu", 2, 1, 0x6f, 0x7f, 0, Form::MOVE, 0, AVX, AVX},
+        {"vmovdqa", 1, 1, 0x6f, 0x7f, 0, Form::MOVE, 0, AVX, AVX},
+};
+// clang-format on
+
+//! a 64 bits general purpose register instruction with a rex.w prefix
+struct GprInst {
+    const char* name;
+    //! 0x0f for the two bytes opcodes, 0 otherwise
+    uint8_t escape;
+    //! op r/m64, r64, except imul, the only two bytes opcode, which is
+    //! op r64, r/m64
+    uint8_t opcode;
+    //! op r64, m64
+    uint8_t load_opcode;
+    //! op m64, r64, 0 if there is no store form
+    uint8_t store_opcode;
+    size_t flops;
+};
+
+const GprInst GPR_INSTS[] = {
+        {"add", 0, 0x01, 0x03, 0x01, 1},  {"sub", 0, 0x29, 0x2b, 0x29, 1},
+        {"and", 0, 0x21, 0x23, 0x21, 1},  {"or", 0, 0x09, 0x0b, 0x09, 1},
+        {"xor", 0, 0x31, 0x33, 0x31, 1},  {"imul", 0x0f, 0xaf, 0xaf, 0, 1},
+        {"mov", 0, 0x89, 0x8b, 0x89, 0},
+};
+
+//! ymm0 - ymm14, all of them are caller saved
+constexpr size_t NR_VEC_REGS = 15;
+//! rdi is the loop counter, rsi the memory and rsp the stack
+const uint8_t GPR_REGS[] = {0, 1, 2, 3, 5, 8, 9, 10, 11, 12, 13, 14};
+constexpr size_t NR_GPR_REGS = sizeof(GPR_REGS) / sizeof(GPR_REGS[0]);
+constexpr uint8_t RSI = 6;
+//! ymm15 and r15 stay zero and are the second source of the register forms,
+//! op r, r, r would be a zeroing idiom for xor and sub, which the renamer
+//! resolves without executing it
+constexpr uint8_t ZERO_VEC = 15, ZERO_GPR = 15;
+//! registers of a class the write-only loads rotate over in the throughput
+//! loop, see emit_loop()
+constexpr size_t NR_LOAD_REGS = 2;
+//! the mix is repeated until a loop iteration has at least this many
+//! instructions, so the loop tail is negligible and all the registers are used
+constexpr size_t MIN_LOOP_INSTS = 32;
+//! stride of the memory operands in the 2048 bytes buffer
+constexpr size_t MEM_STRIDE = 64;
+constexpr size_t NR_MEM_SLOTS = 2048 / MEM_STRIDE;
+
+enum class Access { REG, LOAD, STORE };
+
+//! an instruction of the mix with its resolved encoding
+struct Op {
+    const VexInst* vex = nullptr;
+    const GprInst* gpr = nullptr;
+    bool nop = false;
+    bool ymm = true;
+    Access access = Access::REG;
+};
+
+const char* isa_name(SIMDType type) {
+    switch (type) {
+        case SIMDType::AVX:
+            return "avx";
+        case SIMDType::AVX2:
+            return "avx2";
+        case SIMDType::FMA:
+            return "fma";
+        default:
+            return "unknown";
+    }
+}
+
+Op resolve(const MixInst& inst) {
+    Op op;
+    for (auto&& vex : VEX_INSTS) {
+        if (inst.mnemonic == vex.name) {
+            op.vex = &vex;
+        }
+    }
+    for (auto&& gpr : GPR_INSTS) {
+        if (inst.mnemonic == gpr.name) {
+            op.gpr = &gpr;
+        }
+    }
+    op.nop = inst.mnemonic == "nop";
+    megpeak_assert(op.vex || op.gpr || op.nop,
+                   "unknown instruction \"%s\" in the mix",
+                   inst.text.c_str());
+    for (auto&& operand : inst.operands) {
+        if (operand == "xmm" && op.vex) {
+            op.ymm = false;
+        } else if (operand == "ymm" && op.vex) {
+            op.ymm = true;
+        } else if (operand == "r64" && op.gpr) {
+            //! the only register class of the gpr instructions
+        } else if (operand == "load" && !op.nop) {
+            op.access = Access::LOAD;
+        } else if (operand == "store" && !op.nop) {
+            op.access = Access::STORE;
+        } else {
+            megpeak_assert(false,
+                           "invalid operand %s of \"%s\", expect "
+                           "xmm/ymm/load/store for avx and r64/load/store "
+                           "for the general purpose registers, zmm is not "
+                           "supported",
+                           operand.c_str(), inst.text.c_str());
+        }
+    }
+    bool can_store = op.vex ? op.vex->form == Form::MOVE
+                            : op.gpr && op.gpr->store_opcode;
+    megpeak_assert(op.access != Access::STORE || can_store,
+                   "\"%s\" has no store form", inst.text.c_str());
+    //! a move between registers is eliminated by the renamer and would cut
+    //! the latency chain
+    bool reg_move = op.access == Access::REG && op.gpr &&
+                    op.gpr->opcode == 0x89;
+    megpeak_assert(!reg_move,
+                   "\"%s\" between registers is not supported, use it with "
+                   "load or store",
+                   inst.text.c_str());
+    return op;
+}
+
+class Emitter {
+public:
+    std::vector<uint8_t>& code() { return m_code; }
+
+    void byte(uint8_t value) { m_code.push_back(value); }
+    void dword(uint32_t value) {
+        for (size_t i = 0; i < 4; i++) {
+            byte(value >> (i * 8));
+        }
+    }
+
+    //! three bytes vex prefix, rm is 0 for the memory operands
+    void vex(uint8_t pp, uint8_t map, uint8_t w, bool ymm, uint8_t reg,
+             uint8_t vvvv, uint8_t rm) {
+        byte(0xc4);
+        byte((!(reg & 8)) << 7 | 1 << 6 | (!(rm & 8)) << 5 | map);
+        byte(w << 7 | (~vvvv & 0xf) << 3 | ymm << 2 | pp);
+    }
+    void rex_w(uint8_t reg, uint8_t rm) {
+        byte(0x48 | (reg >> 3) << 2 | (rm >> 3));
+    }
+    void modrm_reg(uint8_t reg, uint8_t rm) {
+        byte(0xc0 | (reg & 7) << 3 | (rm & 7));
+    }
+    //! [rsi + disp32]
+    void modrm_mem(uint8_t reg, uint32_t disp) {
+        byte(0x80 | (reg & 7) << 3 | RSI);
+        dword(disp);
+    }
+
+    void emit(const Op& op, uint8_t reg, uint32_t disp) {
+        if (op.nop) {
+            byte(0x90);
+        } else if (op.vex) {
+            emit_vex(*op.vex, op, reg, disp);
+        } else {
+            emit_gpr(*op.gpr, op, reg, disp);
+        }
+    }
+
+private:
+    void emit_vex(const VexInst& inst, const Op& op, uint8_t reg,
+                  uint32_t disp) {
+        bool mem = op.access != Access::REG;
+        bool nds = inst.form == Form::NDS;
+        uint8_t vvvv = nds ? reg : 0;
+        uint8_t src = nds ? ZERO_VEC : reg;
+        vex(inst.pp, inst.map, inst.w, op.ymm, reg, vvvv, mem ? 0 : src);
+        byte(op.access == Access::STORE ? inst.store_opcode : inst.opcode);
+        if (mem) {
+            modrm_mem(reg, disp);
+        } else {
+            modrm_reg(reg, src);
+        }
+    }
+
+    void emit_gpr(const GprInst& inst, const Op& op, uint8_t reg,
+                  uint32_t disp) {
+        //! the destination is in r/m, except for imul
+        uint8_t modrm = inst.escape ? reg : ZERO_GPR;
+        uint8_t rm = inst.escape ? ZERO_GPR : reg;
+        if (op.access == Access::REG) {
+            rex_w(modrm, rm);
+        } else {
+            rex_w(reg, 0);
+        }
+        if (inst.escape) {
+            byte(inst.escape);
+        }
+        switch (op.access) {
+            case Access::REG:
+                byte(inst.opcode);
+                modrm_reg(modrm, rm);
+                break;
+            case Access::LOAD:
+                byte(inst.load_opcode);
+                modrm_mem(reg, disp);
+                break;
+            case Access::STORE:
+                byte(inst.store_opcode);
+                modrm_mem(reg, disp);
+                break;
+        }
+    }
+
+    std::vector<uint8_t> m_code;
+};
+
+bool is_write_only(const Op& op) {
+    if (op.access != Access::LOAD) {
+        return false;
+    }
+    return op.vex ? op.vex->form != Form::NDS : op.gpr->opcode == 0x89;
+}
+
+//! push/pop of the callee saved rbx, rbp, r12 - r15
+const uint8_t CALLEE_SAVED[] = {3, 5, 12, 13, 14, 15};
+
+/**
+ * void (size_t runs in rdi, void* mem in rsi), with latency all the
+ * instructions use ymm0/rax, otherwise the registers are allocated round
+ * robin, ymm15/r15 are always the zero second source
+ */
+std::vector<uint8_t> emit_loop(const std::vector<Op>& ops, size_t nr_passes,
+                               bool latency) {
+    Emitter e;
+    for (auto reg : CALLEE_SAVED) {
+        if (reg & 8) {
+            e.byte(0x41);
+        }
+        e.byte(0x50 | (reg & 7));
+    }
+    bool has_vex = std::any_of(ops.begin(), ops.end(),
+                               [](const Op& op) { return op.vex; });
+    //! zero all the registers, so that no instruction runs on denormals
+    if (has_vex) {
+        for (uint8_t reg = 0; reg <= ZERO_VEC; reg++) {
+            //! vpxor xmm, xmm, xmm
+            e.vex(1, 1, 0, false, reg, reg, reg);
+            e.byte(0xef);
+            e.modrm_reg(reg, reg);
+        }
+    }
+    for (auto reg : GPR_REGS) {
+        //! xor r64, r64
+        e.rex_w(reg, reg);
+        e.byte(0x31);
+        e.modrm_reg(reg, reg);
+    }
+    e.rex_w(ZERO_GPR, ZERO_GPR);
+    e.byte(0x31);
+    e.modrm_reg(ZERO_GPR, ZERO_GPR);
+    while (e.code().size() % 64) {
+        e.byte(0x90);
+    }
+
+    //! when the mix has other instructions, the write-only loads rotate over
+    //! the last registers of a class, otherwise the instructions reading
+    //! the register after a load would wait for the load latency
+    bool has_loads = std::any_of(ops.begin(), ops.end(), is_write_only);
+    bool has_others = !std::all_of(ops.begin(), ops.end(), is_write_only);
+    size_t nr_load_regs = has_loads && has_others ? NR_LOAD_REGS : 0;
+    //! number of registers allocated of a class, of others and of loads
+    size_t nr_vec[2] = {0, 0}, nr_gpr[2] = {0, 0}, nr_mem = 0;
+    auto next_reg = [&](size_t* counters, size_t nr_regs, bool load) {
+        return load ? nr_regs - nr_load_regs + counters[1]++ % nr_load_regs
+                    : counters[0]++ % (nr_regs - nr_load_regs);
+    };
+
+    size_t loop = e.code().size();
+    for (size_t i = 0; i < nr_passes; i++) {
+        for (auto&& op : ops) {
+            //! loads which only write the register would cut the chain,
+            //! they write the next register instead
+            size_t latency_reg = is_write_only(op) ? 1 : 0;
+            bool load = nr_load_regs && is_write_only(op);
+            uint8_t reg = 0;
+            if (op.vex) {
+                reg = latency ? latency_reg
+                              : next_reg(nr_vec, NR_VEC_REGS, load);
+            } else if (op.gpr) {
+                reg = GPR_REGS[latency ? latency_reg
+                                       : next_reg(nr_gpr, NR_GPR_REGS, load)];
+            }
+            uint32_t disp = 0;
+            if (op.access != Access::REG) {
+                disp = nr_mem++ % NR_MEM_SLOTS * MEM_STRIDE;
+            }
+            e.emit(op, reg, disp);
+        }
+    }
+    //! sub rdi, 1; jne loop
+    for (uint8_t value : {0x48, 0x83, 0xef, 0x01, 0x0f, 0x85}) {
+        e.byte(value);
+    }
+    e.dword(static_cast<uint32_t>(loop - (e.code().size() + 4)));
+
+    if (has_vex) {
+        //! vzeroupper
+        for (uint8_t value : {0xc5, 0xf8, 0x77}) {
+            e.byte(value);
+        }
+    }
+    for (size_t i = sizeof(CALLEE_SAVED); i > 0; i--) {
+        uint8_t reg = CALLEE_SAVED[i - 1];
+        if (reg & 8) {
+            e.byte(0x41);
+        }
+        e.byte(0x58 | (reg & 7));
+    }
+    e.byte(0xc3);
+    return std::move(e.code());
+}
+}  // namespace
+
+MixCode megpeak::assemble_mix(const std::vector<MixInst>& mix) {
+    MixCode ret;
+    std::vector<Op> ops;
+    std::vector<SIMDType> isas;
+    for (auto&& inst : mix) {
+        auto op = resolve(inst);
+        if (op.vex) {
+            auto isa = op.ymm ? op.vex->isa256 : op.vex->isa128;
+            megpeak_assert(is_supported(isa),
+                           "\"%s\" requires %s, which is not supported",
+                           inst.text.c_str(), isa_name(isa));
+            if (std::find(isas.begin(), isas.end(), isa) == isas.end()) {
+                isas.push_back(isa);
+                ret.isa += (ret.isa.empty() ? "" : ",") +
+                           std::string(isa_name(isa));
+            }
+            ret.flops += op.ymm ? op.vex->flops : op.vex->flops / 2;
+        } else if (op.gpr) {
+            ret.flops += op.gpr->flops;
+        }
+        ops.push_back(op);
+    }
+    ret.nr_passes = std::max<size_t>(
+            (MIN_LOOP_INSTS + ops.size() - 1) / ops.size(), 1);
+    ret.throughput = emit_loop(ops, ret.nr_passes, false);
+    ret.latency = emit_loop(ops, ret.nr_passes, true);
+    return ret;
+}
+#endif
+
+// vim: syntax=cpp.doxygen
@@ -10,6 +10,7 @@
  */
 
 #include "src/cpu/common.h"
+#include "src/cpu/registry.h"
 #include "src/cpu/x86_utils.h"
 
 #if MEGPEAK_X86
@@ -19,35 +20,35 @@
 // clang-format off
 #define THROUGHPUT(cb, func, simd)                                 \
     MEGPEAK_ATTRIBUTE_TARGET(simd)                                 \
-    static int func##_throughput() {                               \
+    static size_t func##_throughput(size_t runs) {                 \
         asm volatile(                                              \
         UNROLL_CALL(10, eor)                                       \
-        "movl %[RUNS], %%eax \n"                                   \
+        "mov %[RUNS], %%rax \n"                                    \
         "1:\n"                                                     \
         UNROLL_CALL(10, cb)                                        \
-        "sub  $0x01, %%eax\n"                                      \
+        "sub  $0x01, %%rax\n"                                      \
         "jne 1b \n"                                                \
         :                                                          \
-        :[RUNS] "r"(megpeak::RUNS * 100)                           \
+        :[RUNS] "r"(runs)                                          \
         : "%xmm0", "%xmm1", "%xmm2", "%xmm3", "%xmm4", "%xmm5",    \
-           "%xmm6", "%xmm7", "%xmm8", "%xmm9", "%eax", "cc");      \
-        return megpeak::RUNS * 100 * 10;                           \
+           "%xmm6", "%xmm7", "%xmm8", "%xmm9", "%rax", "cc");      \
+        return runs * 10;                                          \
     }
 
-#define LATENCY(cb, func, simd)          \
-    MEGPEAK_ATTRIBUTE_TARGET(simd)       \
-    static int func##_latency() {        \
-        asm volatile(                    \
-        "xorpd %%xmm0, %%xmm0\n"         \
-        "movl %[RUNS], %%eax \n"         \
-        "1:\n"                           \
-        UNROLL_CALL(10, cb)              \
-        "sub  $0x01, %%eax\n"            \
-        "jne 1b \n"                      \
-        :                                \
-        :[RUNS] "r"(megpeak::RUNS * 100) \
-        : "%xmm0", "%eax", "cc");        \
-        return megpeak::RUNS * 100 * 10; \
+#define LATENCY(cb, func, simd)                 \
+    MEGPEAK_ATTRIBUTE_TARGET(simd)              \
+    static size_t func##_latency(size_t runs) { \
+        asm volatile(                           \
+        "xorpd %%xmm0, %%xmm0\n"                \
+        "mov %[RUNS], %%rax \n"                 \
+        "1:\n"                                  \
+        UNROLL_CALL(10, cb)                     \
+        "sub  $0x01, %%rax\n"                   \
+        "jne 1b \n"                             \
+        :                                       \
+        :[RUNS] "r"(runs)                       \
+        : "%xmm0", "%rax", "cc");               \
+        return runs * 10;                       \
     }
 // clang-format on
 #define cb(i) "mulps %%xmm" #i ", %%xmm" #i "\n"
@@ -83,22 +84,37 @@ THROUGHPUT(cb, vpmaddwd_vpaddd, "sse4.2")
 LATENCY(cb, vpmaddwd_vpaddd, "sse4.2")
 #undef cb
 
+using namespace megpeak;
+
+namespace {
+bool sse2_supported() {
+    return is_supported(SIMDType::SSE2);
+}
+bool fma_supported() {
+    return is_supported(SIMDType::FMA);
+}
+}  // namespace
+
+//! sse2 is 128 width, mul + add = 2 ops
+MEGPEAK_REGISTER_BENCHMARK(x86_sse, mulps, "mulps_sse", "sse2",
+                           sse2_supported, 4 * 2, "fp32")
+MEGPEAK_REGISTER_BENCHMARK(x86_sse, mulpd, "mulpd_sse", "sse2",
+                           sse2_supported, 2 * 2, "fp64")
+MEGPEAK_REGISTER_BENCHMARK(x86_sse, vfmadd132ps, "vfmadd132ps_sse", "fma",
+                           fma_supported, 4 * 2, "fp32,fma")
+MEGPEAK_REGISTER_BENCHMARK(x86_sse, vpmaddwd_vpaddd, "vpmaddwd_vpaddd_sse",
+                           "sse2", sse2_supported, 8 + 4 + 4, "int16,mixed")
+
+//! the jit only encodes vex, whose 128 bits forms issue like the sse ones
+MEGPEAK_REGISTER_MIX(x86_sse, mulps, "mulps_sse", "vmulps xmm")
+MEGPEAK_REGISTER_MIX(x86_sse, mulpd, "mulpd_sse", "vmulpd xmm")
+MEGPEAK_REGISTER_MIX(x86_sse, vfmadd132ps, "vfmadd132ps_sse", "vfmadd132ps xmm")
+
 void megpeak::x86_sse() {
-    if (is_supported(SIMDType::SSE2)) {
-        //! warmup
-        for (size_t i = 0; i < 10; i++) {
-            mulps_throughput();
-        }
-        //! sse2 is 128 width, mul + add = 2 ops
-        benchmark(mulps_throughput, mulps_latency, "mulps_sse", 4 * 2);
-        benchmark(mulpd_throughput, mulpd_latency, "mulpd_sse", 2 * 2);
-        benchmark(vfmadd132ps_throughput, vfmadd132ps_latency,
-                  "vfmadd132ps_sse", 4 * 2);
-        benchmark(vpmaddwd_vpaddd_throughput, vpmaddwd_vpaddd_latency,
-                  "vpmaddwd_vpaddd_sse", 8 + 4 + 4);
-    } else {
+    if (!is_supported(SIMDType::SSE2)) {
         printf("this x86 CPU does not support sse2.\n");
     }
+    run_benchmarks(select_benchmarks("x86_sse"));
 }
 #else
 void megpeak::x86_sse() {}
@@ -9,37 +9,234 @@
  * implied.
  */
 
+#include <errno.h>
 #include <getopt.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <algorithm>
+#include <cmath>
 #include <memory>
+#include <regex>
+#include <sstream>
 #include <string>
 
 #include "backend.h"
+#include "baseline.h"
+#include "cpu/buffer.h"
+#include "cpu/perf_event.h"
+#include "cpu/topology.h"
+#include "options.h"
+#include "report.h"
 
 void usage() {
     fprintf(stderr, "\n");
     fprintf(stderr, "Get the peak performance for the device\n");
     fprintf(stderr,
             "Usage: megpeak [--device|-d] [cpu/opencl] [-i|--dev-id] "
-            "<dev_id> \n");
+            "<dev_id> [-s|--samples] <nr_samples> [-m|--min-time] <ms> "
+            "[--warmup-tolerance] <percent> [--max-warmup] <ms> "
+            "[--ilp] <max_chains> [--mix] <insts> "
+            "[--mix-dump] <file> [--ports] <insts> [--pairs] [--ratio] <insts> "
+            "[--threads] <nr_threads> [--cores] <cpu_list> [--all-cores] "
+            "[--smt] [--c2c] [--sweep] <max_size> [--latency] <max_size> "
+            "[--tlb] <max_span> [--pages] <4k|thp|hugetlb> [-p|--pmu] "
+            "[--pmu-events] <events> [--filter] <regex> [--tag] <tags> "
+            "[--list] [--format] <json|csv> [-o|--output] <file> "
+            "[--save-baseline] <file> [--compare] <file> [--threshold] "
+            "<percent>\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "  -d, --device   default is cpu\n");
     fprintf(stderr, "  -i, --dev-id   device id for the device\n");
+    fprintf(stderr,
+            "  -s, --samples  number of samples for each benchmark, default "
+            "is %zu\n",
+            megpeak::get_options().nr_samples);
+    fprintf(stderr,
+            "  -m, --min-time time of each sample in ms, the loop count of "
+            "every benchmark is calibrated to it, default is %.0f\n",
+            megpeak::get_options().min_time_ms);
+    fprintf(stderr,
+            "  --warmup-tolerance  change in percent between successive "
+            "warm-up probes below which the speed is stable, default is "
+            "%.1f\n",
+            megpeak::get_options().warmup_tolerance * 100);
+    fprintf(stderr,
+            "  --max-warmup   upper bound of the warm-up of every benchmark "
+            "in ms, 0 to disable, default is %.0f\n",
+            megpeak::get_options().max_warmup_ms);
+    fprintf(stderr,
+            "  --ilp          sweep 1 to max_chains(at most 16) independent "
+            "chains of the benchmarks tagged ilp, instead of the "
+            "throughput/latency pair\n");
+    fprintf(stderr,
+            "  --mix          benchmark the instructions assembled at "
+            "runtime instead of the suites, e.g. \"vfmadd231ps ymm; vpaddd "
+            "ymm; vmovups load\", operands are xmm/ymm/r64/load/store on "
+            "x86-64, an arrangement/lane/x/q/d/s on aarch64, e.g. \"fmla "
+            "4s; fmla lane; ldr q\"\n");
+    fprintf(stderr,
+            "  --mix-dump     write the machine code of the throughput loop "
+            "of the mix to a file, to disassemble it\n");
+    fprintf(stderr,
+            "  --ports        infer the execution ports of 2 to 8 "
+            "instructions in the --mix syntax from the throughput of their "
+            "pairs and triples\n");
+    fprintf(stderr,
+            "  --pairs        run every pair of the selected x86 vector "
+            "benchmarks interleaved 1:1 and print the co-issue matrix\n");
+    fprintf(stderr,
+            "  --ratio        sweep the first of 2 or 3 instructions in the "
+            "--mix syntax against the others from 1:8 to 8:1\n");
+    fprintf(stderr,
+            "  --threads      run every benchmark on nr_threads cores at "
+            "once, from the core of --dev-id, and report the aggregate and "
+            "per core results\n");
+    fprintf(stderr,
+            "  --cores        like --threads on the given cores, e.g. "
+            "0-3,8\n");
+    fprintf(stderr,
+            "  --all-cores    run the benchmarks on every online core, group "
+            "the cores into clusters by topology and measured speed and "
+            "report once per cluster, for big.LITTLE and hybrid cpus\n");
+    fprintf(stderr,
+            "  --smt          run every pair of the selected benchmarks on the "
+            "two smt threads of the core of --dev-id and print the rate of "
+            "each thread relative to running alone\n");
+    fprintf(stderr,
+            "  --c2c          print the round trip latency of a cache line "
+            "between every pair of the --cores cores, all the online cores "
+            "by default\n");
+    fprintf(stderr,
+            "  --sweep        sweep the working set of the read, write and "
+            "copy kernels from 4K to max_size, e.g. 4G, and print the "
+            "bandwidth of each cache level\n");
+    fprintf(stderr,
+            "  --latency      load-to-use latency of random and sequential "
+            "pointer chasing over working sets from 4K to max_size, e.g. "
+            "1G, in ns and cycles\n");
+    fprintf(stderr,
+            "  --tlb          extra latency of touching one line per page "
+            "over spans up to max_span, e.g. 1G, and the reach of each tlb "
+            "level, with 4k and thp pages unless --pages is given\n");
+    fprintf(stderr,
+            "  --pages        comma separated pages of the buffers of the "
+            "memory benchmarks, 4k, thp(madvise) or hugetlb(MAP_HUGETLB), "
+            "each one is run with every page size, default is 4k\n");
+    fprintf(stderr,
+            "  -p, --pmu      collect cycles, instructions and stalled "
+            "cycles of every benchmark with perf_event_open\n");
+    fprintf(stderr,
+            "  --pmu-events   comma separated extra pmu events, generic name "
+            "or raw event like r01b1 or port0=r01b1, implies --pmu\n");
+    fprintf(stderr,
+            "  --filter       only run the benchmarks whose name matches the "
+            "regex\n");
+    fprintf(stderr,
+            "  --tag          comma separated tags, only run the benchmarks "
+            "with one of them, e.g. fma,int8\n");
+    fprintf(stderr,
+            "  --list         list the benchmarks with their tags and "
+            "whether they are selected, then exit\n");
+    fprintf(stderr,
+            "  --format       also write the results in json or csv, with the "
+            "environment of the run\n");
+    fprintf(stderr,
+            "  -o, --output   file of the --format results, default is "
+            "stdout after all the benchmarks\n");
+    fprintf(stderr,
+            "  --save-baseline  save the results as a baseline csv file\n");
+    fprintf(stderr,
+            "  --compare      compare the results with a baseline, exit with "
+            "2 if any metric regressed\n");
+    fprintf(stderr,
+            "  --threshold    change in percent beyond which a significant "
+            "change is a regression, default is %.1f\n",
+            megpeak::get_options().regression_threshold * 100);
     fprintf(stderr, "\n");
 }
 
+//! parse a count of at least \p min, exit with the usage on garbage
+size_t parse_count(const char* option, const char* arg, long min) {
+    char* end = nullptr;
+    errno = 0;
+    long value = strtol(arg, &end, 10);
+    if (end == arg || *end != '\0' || errno == ERANGE || value < min) {
+        fprintf(stderr, "Invalid %s: %s, expect an integer >= %ld\n", option,
+                arg, min);
+        usage();
+        exit(1);
+    }
+    return static_cast<size_t>(value);
+}
+
+//! parse a number above 0, or from 0 with \p zero, exit with the usage on
+//! garbage
+double parse_number(const char* option, const char* arg, bool zero) {
+    char* end = nullptr;
+    errno = 0;
+    double value = strtod(arg, &end);
+    if (end == arg || *end != '\0' || errno == ERANGE ||
+        !std::isfinite(value) || value < 0 || (!zero && value == 0)) {
+        fprintf(stderr, "Invalid %s: %s, expect a number %s 0\n", option,
+                arg, zero ? ">=" : ">");
+        usage();
+        exit(1);
+    }
+    return value;
+}
+
+//! parse a size of memory like 512K or 4G, exit with the usage on garbage
+size_t parse_bytes(const char* option, const char* arg) {
+    size_t bytes = 0;
+    if (!megpeak::parse_size(arg, bytes)) {
+        fprintf(stderr, "Invalid %s: %s, expect a size like 512K or 4G\n",
+                option, arg);
+        usage();
+        exit(1);
+    }
+    return bytes;
+}
+
 int main(int argc, char** argv) {
     int c;
     static struct option loptions[] = {{"help", no_argument, NULL, 'h'},
                                        {"device", required_argument, NULL, 'd'},
                                        {"dev-id", required_argument, NULL, 'i'},
+                                       {"samples", required_argument, NULL, 's'},
+                                       {"min-time", required_argument, NULL, 'm'},
+                                       {"warmup-tolerance", required_argument, NULL, 'W'},
+                                       {"max-warmup", required_argument, NULL, 'M'},
+                                       {"ilp", required_argument, NULL, 'I'},
+                                       {"mix", required_argument, NULL, 'x'},
+                                       {"mix-dump", required_argument, NULL, 'X'},
+                                       {"ports", required_argument, NULL, 'R'},
+                                       {"pairs", no_argument, NULL, 'A'},
+                                       {"ratio", required_argument, NULL, 'Y'},
+                                       {"threads", required_argument, NULL, 'N'},
+                                       {"cores", required_argument, NULL, 'c'},
+                                       {"all-cores", no_argument, NULL, 'G'},
+                                       {"smt", no_argument, NULL, 'H'},
+                                       {"c2c", no_argument, NULL, 'K'},
+                                       {"sweep", required_argument, NULL, 'B'},
+                                       {"latency", required_argument, NULL, 'J'},
+                                       {"tlb", required_argument, NULL, 'U'},
+                                       {"pages", required_argument, NULL, 'Q'},
+                                       {"pmu", no_argument, NULL, 'p'},
+                                       {"pmu-events", required_argument, NULL, 'P'},
+                                       {"filter", required_argument, NULL, 'f'},
+                                       {"tag", required_argument, NULL, 't'},
+                                       {"list", no_argument, NULL, 'l'},
+                                       {"format", required_argument, NULL, 'F'},
+                                       {"output", required_argument, NULL, 'o'},
+                                       {"save-baseline", required_argument, NULL, 'S'},
+                                       {"compare", required_argument, NULL, 'C'},
+                                       {"threshold", required_argument, NULL, 'T'},
                                        {NULL, 0, NULL, 0}};
 
     size_t dev_id = 0;
     std::string device = "cpu";
     std::unique_ptr<megpeak::Backend> backend;
-    while ((c = getopt_long(argc, argv, "h?d:i:", loptions, NULL)) != -1) {
+    while ((c = getopt_long(argc, argv, "h?d:i:s:m:po:", loptions, NULL)) != -1) {
         switch (c) {
             case 'd':
                 device = optarg;
@@ -49,6 +246,149 @@ int main(int argc, char** argv) {
             case 'i':
                 dev_id = std::atoi(optarg);
                 break;
+            case 's':
+                megpeak::get_options().nr_samples =
+                        parse_count("--samples", optarg, 1);
+                break;
+            case 'm':
+                megpeak::get_options().min_time_ms =
+                        parse_number("--min-time", optarg, false);
+                break;
+            case 'W':
+                megpeak::get_options().warmup_tolerance =
+                        parse_number("--warmup-tolerance", optarg, false) /
+                        100;
+                break;
+            case 'M':
+                megpeak::get_options().max_warmup_ms =
+                        parse_number("--max-warmup", optarg, true);
+                break;
+            case 'I':
+                megpeak::get_options().ilp_chains =
+                        parse_count("--ilp", optarg, 1);
+                break;
+            case 'x':
+                megpeak::get_options().mix = optarg;
+                break;
+            case 'X':
+                megpeak::get_options().mix_dump = optarg;
+                break;
+            case 'R':
+                megpeak::get_options().ports = optarg;
+                break;
+            case 'A':
+                megpeak::get_options().pairs = true;
+                break;
+            case 'Y':
+                megpeak::get_options().ratio = optarg;
+                break;
+            case 'N':
+                megpeak::get_options().nr_threads =
+                        parse_count("--threads", optarg, 1);
+                break;
+            case 'c':
+                megpeak::get_options().cores = megpeak::parse_cpu_list(optarg);
+                break;
+            case 'G':
+                megpeak::get_options().all_cores = true;
+                break;
+            case 'H':
+                megpeak::get_options().smt = true;
+                break;
+            case 'K':
+                megpeak::get_options().core_to_core = true;
+                break;
+            case 'B':
+                megpeak::get_options().sweep_max_bytes =
+                        parse_bytes("--sweep", optarg);
+                break;
+            case 'J':
+                megpeak::get_options().latency_max_bytes =
+                        parse_bytes("--latency", optarg);
+                break;
+            case 'U':
+                megpeak::get_options().tlb_max_bytes =
+                        parse_bytes("--tlb", optarg);
+                break;
+            case 'Q': {
+                std::stringstream pages(optarg);
+                std::string name;
+                while (std::getline(pages, name, ',')) {
+                    megpeak::PageSize page_size;
+                    if (!megpeak::parse_page_size(name, page_size)) {
+                        fprintf(stderr, "Invalid page size: %s\n",
+                                name.c_str());
+                        usage();
+                        exit(1);
+                    }
+                    megpeak::get_options().pages.push_back(name);
+                }
+                break;
+            }
+            case 'p':
+                megpeak::get_options().enable_pmu = true;
+                break;
+            case 'P': {
+                std::stringstream events(optarg);
+                std::string event;
+                while (std::getline(events, event, ',')) {
+                    megpeak::PerfEventDesc desc;
+                    if (!megpeak::parse_perf_event(event, desc)) {
+                        fprintf(stderr, "Invalid pmu event: %s\n",
+                                event.c_str());
+                        usage();
+                        exit(1);
+                    }
+                    megpeak::get_options().pmu_events.push_back(event);
+                }
+                megpeak::get_options().enable_pmu = true;
+                break;
+            }
+            case 'f':
+                try {
+                    std::regex filter(optarg);
+                } catch (const std::regex_error& e) {
+                    fprintf(stderr, "Invalid filter %s: %s\n", optarg,
+                            e.what());
+                    usage();
+                    exit(1);
+                }
+                megpeak::get_options().filter = optarg;
+                break;
+            case 't': {
+                std::stringstream tags(optarg);
+                std::string tag;
+                while (std::getline(tags, tag, ',')) {
+                    megpeak::get_options().tags.push_back(tag);
+                }
+                break;
+            }
+            case 'l':
+                megpeak::get_options().list = true;
+                break;
+            case 'F': {
+                megpeak::ResultSink::Format format;
+                if (!megpeak::parse_format(optarg, format)) {
+                    fprintf(stderr, "Invalid format: %s\n", optarg);
+                    usage();
+                    exit(1);
+                }
+                megpeak::get_options().format = optarg;
+                break;
+            }
+            case 'o':
+                megpeak::get_options().output = optarg;
+                break;
+            case 'S':
+                megpeak::get_options().save_baseline = optarg;
+                break;
+            case 'C':
+                megpeak::get_options().compare = optarg;
+                break;
+            case 'T':
+                megpeak::get_options().regression_threshold =
+                        parse_number("--threshold", optarg, true) / 100;
+                break;
             default:
                 usage();
                 exit(-1);
@@ -65,6 +405,22 @@ int main(int argc, char** argv) {
         exit(1);
     }
     backend->execute();
+    auto&& options = megpeak::get_options();
+    if (auto sink = megpeak::get_result_sink()) {
+        if (!options.format.empty()) {
+            megpeak::ResultSink::Format format;
+            megpeak::parse_format(options.format, format);
+            sink->write(format, options.output);
+        }
+        if (!options.save_baseline.empty()) {
+            megpeak::save_baseline(*sink, options.save_baseline);
+        }
+        if (!options.compare.empty() &&
+            megpeak::compare_baseline(*sink, options.compare,
+                                      options.regression_threshold) > 0) {
+            return 2;
+        }
+    }
 
     return 0;
 }
@@ -19,10 +19,17 @@
 #include <MCL/cl.h>
 
 #include "src/opencl/common.h"
+#include "src/report.h"
 
 void megpeak::OpenCLBackend::execute() {
     OpenCLEnv env(m_dev_id);
     env.print_device_info();
+    if (auto sink = get_result_sink()) {
+        auto&& info = sink->environment();
+        info.backend = "opencl";
+        info.device_id = m_dev_id;
+        info.device_name = env.device_info().device_name;
+    }
     env.run();
 }
 
@@ -12,6 +12,7 @@
 #ifdef MEGPEAK_WITH_OPENCL
 #include "src/opencl/common.h"
 #include "src/backend.h"
+#include "src/report.h"
 
 #include <vector>
 #include <cstring>
@@ -258,6 +259,7 @@ void LocalMemRunner::run_step(cl_kernel kernel, size_t global_size,
             (6LL + 4 * 5 * TOTAL_ITERATIONS + 6) * nr_elems * sizeof(int);
     float gdps = memory / used / 1e3;
     printf("    %s : %f\n", tag.c_str(), gdps);
+    report_result("opencl_local_memory", tag, "", "bandwidth", "GB/s", gdps);
 }
 
 ///////////////////////// GlobalMemRunner /////////////////////////////////////
@@ -331,6 +333,7 @@ void GlobalMemRunner::run_step(cl_kernel kernel_go, cl_kernel kernel_lo,
     float used = std::min<float>(used_lo, used_go);
     float gdps = static_cast<float>(nr_elems) * sizeof(float) / used / 1e3;
     printf("    %s : %f\n", tag.c_str(), gdps);
+    report_result("opencl_global_memory", tag, "", "bandwidth", "GB/s", gdps);
 }
 
 ///////////////////////// CompRunner /////////////////////////////////////
@@ -427,6 +430,7 @@ void CompRunner<T>::run_step(cl_kernel kernel, size_t global_size,
     float used = run_kernel(kernel, global_size, local_size, iters);
     float gflops = static_cast<float>(global_size) * work_per_wi / used / 1e3;
     printf("    %s : %f\n", tag.c_str(), gflops);
+    report_result("opencl_compute", tag, "", "gflops", "GFlops", gflops);
 }
 
 }  // namespace megpeak
@@ -188,6 +188,7 @@ public:
 
     cl_program build_program(const std::string& source_name) const;
     void print_device_info() const;
+    const DeviceInfo& device_info() const { return m_dev_info; }
     void run() const;
 
 private:
@@ -0,0 +1,101 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace megpeak {
+
+//! run time options shared by all the backends, filled by the command line
+struct Options {
+    //! number of samples collected for every throughput/latency kernel
+    size_t nr_samples = 5;
+    //! time of one sample, the loop count of each kernel is calibrated to it
+    double min_time_ms = 50;
+    //! relative difference of successive warm-up probes to be stable
+    double warmup_tolerance = 0.02;
+    //! upper bound of the warm-up of each kernel, 0 to disable the warm-up
+    double max_warmup_ms = 2000;
+    //! sweep 1 ... ilp_chains independent chains instead of the
+    //! throughput/latency pair, 0 for the pair
+    size_t ilp_chains = 0;
+    //! instructions assembled at runtime and benchmarked instead of the
+    //! suites, e.g. "vfmadd231ps ymm; vpaddd ymm; vmovups load"
+    std::string mix;
+    //! file the throughput loop of the mix is written to, to disassemble it
+    std::string mix_dump;
+    //! instructions in the --mix syntax whose execution ports are inferred
+    //! instead of running the suites
+    std::string ports;
+    //! run the selected benchmarks which have a mix pairwise, see
+    //! co_issue_matrix()
+    bool pairs = false;
+    //! 2 or 3 instructions in the --mix syntax swept over their interleave
+    //! ratios instead of running the suites
+    std::string ratio;
+    //! run every benchmark on all these cores at once, empty for the single
+    //! core of --dev-id, see multi_core_benchmark()
+    std::vector<size_t> cores;
+    //! number of cores from --dev-id for cores, when cores is not given
+    size_t nr_threads = 0;
+    //! run the suites on every online core, grouped into clusters of cores
+    //! with the same topology and speed, instead of the core of --dev-id
+    bool all_cores = false;
+    //! run every pair of the selected benchmarks on the smt siblings of the
+    //! core of --dev-id, see smt_interference()
+    bool smt = false;
+    //! print the cache line round trip latency between every pair of the
+    //! cores of cores, or all the online cores, instead of the suites
+    bool core_to_core = false;
+    //! largest working set of the bandwidth sweep which is run instead of
+    //! the suites, 0 for no sweep, see bandwidth_sweep()
+    size_t sweep_max_bytes = 0;
+    //! largest working set of the pointer chasing latency which is run
+    //! instead of the suites, 0 for none, see memory_latency()
+    size_t latency_max_bytes = 0;
+    //! largest span of the tlb reach which is run instead of the suites, 0
+    //! for none, see tlb_reach()
+    size_t tlb_max_bytes = 0;
+    //! pages of the memory benchmarks, 4k, thp or hugetlb, each one of them
+    //! is run with all of them, 4k if empty
+    std::vector<std::string> pages;
+    //! collect the pmu counters of every kernel with perf_event_open
+    bool enable_pmu = false;
+    //! extra pmu events besides the default ones, see parse_perf_event()
+    std::vector<std::string> pmu_events;
+    //! ECMAScript regex, only the benchmarks whose name matches are run
+    std::string filter;
+    //! only the benchmarks with one of the tags are run
+    std::vector<std::string> tags;
+    //! list the registered benchmarks instead of running them
+    bool list = false;
+    //! machine readable format of the results, json or csv, empty for none
+    std::string format;
+    //! file of the machine readable results, stdout if empty
+    std::string output;
+    //! csv file to save the results of the run to as a baseline
+    std::string save_baseline;
+    //! baseline csv file to compare the results of the run with
+    std::string compare;
+    //! relative change of a metric beyond which it is a regression
+    double regression_threshold = 0.02;
+};
+
+inline Options& get_options() {
+    static Options options;
+    return options;
+}
+
+}  // namespace megpeak
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,369 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/report.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/utsname.h>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#endif
+
+#include "src/backend.h"
+#include "src/options.h"
+
+#ifndef MEGPEAK_BUILD_FLAGS
+#define MEGPEAK_BUILD_FLAGS "unknown"
+#endif
+
+using namespace megpeak;
+
+namespace {
+std::string get_compiler() {
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#else
+    return "unknown";
+#endif
+}
+
+std::string get_kernel_version() {
+    struct utsname name;
+    if (uname(&name) != 0) {
+        return "unknown";
+    }
+    return std::string(name.sysname) + " " + name.release;
+}
+
+//! value of the first "key : value" line of /proc/cpuinfo with the key
+std::string read_cpuinfo(const char* key) {
+    std::ifstream fin("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(fin, line)) {
+        auto pos = line.find(':');
+        if (pos == std::string::npos) {
+            continue;
+        }
+        auto name = line.substr(0, line.find_last_not_of(" \t", pos - 1) + 1);
+        if (name == key) {
+            auto begin = line.find_first_not_of(" \t", pos + 1);
+            return begin == std::string::npos ? "" : line.substr(begin);
+        }
+    }
+    return "";
+}
+
+std::string json_escape(const std::string& str) {
+    std::string ret;
+    for (char c : str) {
+        switch (c) {
+            case '"':
+                ret += "\\\"";
+                break;
+            case '\\':
+                ret += "\\\\";
+                break;
+            case '\n':
+                ret += "\\n";
+                break;
+            case '\t':
+                ret += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    ret += buf;
+                } else {
+                    ret += c;
+                }
+        }
+    }
+    return "\"" + ret + "\"";
+}
+
+std::string csv_escape(const std::string& str) {
+    if (str.find_first_of(",\"\n") == std::string::npos) {
+        return str;
+    }
+    std::string ret;
+    for (char c : str) {
+        ret += c == '"' ? "\"\"" : std::string(1, c);
+    }
+    return "\"" + ret + "\"";
+}
+
+std::string number(double value) {
+    if (!std::isfinite(value)) {
+        return "null";
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.9g", value);
+    return buf;
+}
+
+//! name and value of all the columns of a record, in output order
+std::vector<std::pair<std::string, std::string>> fields(
+        const Environment& env, const ResultRecord& record, bool json) {
+    auto str = [json](const std::string& s) {
+        return json ? json_escape(s) : csv_escape(s);
+    };
+    auto&& stats = record.stats;
+    std::string samples;
+    for (auto sample : stats.samples) {
+        samples += (samples.empty() ? "" : json ? "," : ";") + number(sample);
+    }
+    if (json) {
+        samples = "[" + samples + "]";
+    }
+    return {{"backend", str(env.backend)},
+            {"device_id", std::to_string(env.device_id)},
+            {"suite", str(record.suite)},
+            {"name", str(record.name)},
+            {"isa", str(record.isa)},
+            {"metric", str(record.metric)},
+            {"value", number(stats.median)},
+            {"unit", str(record.unit)},
+            {"nr_samples", std::to_string(stats.nr_samples())},
+            {"nr_outliers", std::to_string(stats.nr_outliers)},
+            {"min", number(stats.min)},
+            {"max", number(stats.max)},
+            {"mean", number(stats.mean)},
+            {"stddev", number(stats.stddev)},
+            {"p95", number(stats.p95)},
+            {"ci95_low", number(stats.ci_low)},
+            {"ci95_high", number(stats.ci_high)},
+            {"samples", samples},
+            {"device_name", str(env.device_name)},
+            {"cpu_model", str(env.cpu_model)},
+            {"compiler", str(env.compiler)},
+            {"build_flags", str(env.build_flags)},
+            {"kernel_version", str(env.kernel_version)}};
+}
+
+std::vector<std::string> split_csv(const std::string& line) {
+    std::vector<std::string> ret(1);
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); i++) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                ret.back() += c;
+                i++;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                ret.back() += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            ret.emplace_back();
+        } else {
+            ret.back() += c;
+        }
+    }
+    return ret;
+}
+
+double parse_number(const std::string& str) {
+    return str == "null" ? NAN : strtod(str.c_str(), nullptr);
+}
+}  // namespace
+
+ResultSink::ResultSink() {
+    m_env.cpu_model = get_cpu_model();
+    m_env.compiler = get_compiler();
+    m_env.build_flags = MEGPEAK_BUILD_FLAGS;
+    m_env.kernel_version = get_kernel_version();
+}
+
+void ResultSink::write(Format format, const std::string& output) const {
+    FILE* fp = stdout;
+    if (!output.empty()) {
+        fp = fopen(output.c_str(), "w");
+        megpeak_assert(fp, "can not open %s: %s", output.c_str(),
+                       strerror(errno));
+    }
+    if (format == Format::JSON) {
+        write_json(fp);
+    } else {
+        write_csv(fp);
+    }
+    if (fp != stdout) {
+        fclose(fp);
+    } else {
+        fflush(fp);
+    }
+}
+
+void ResultSink::write_json(FILE* fp) const {
+    fprintf(fp, "[");
+    for (size_t i = 0; i < m_records.size(); i++) {
+        fprintf(fp, "%s\n  {", i ? "," : "");
+        auto columns = fields(m_env, m_records[i], true);
+        for (size_t j = 0; j < columns.size(); j++) {
+            fprintf(fp, "%s\"%s\": %s", j ? ", " : "",
+                    columns[j].first.c_str(), columns[j].second.c_str());
+        }
+        fprintf(fp, "}");
+    }
+    fprintf(fp, "\n]\n");
+}
+
+void ResultSink::write_csv(FILE* fp) const {
+    auto header = fields(m_env, {}, false);
+    for (size_t i = 0; i < header.size(); i++) {
+        fprintf(fp, "%s%s", i ? "," : "", header[i].first.c_str());
+    }
+    fprintf(fp, "\n");
+    for (auto&& record : m_records) {
+        auto columns = fields(m_env, record, false);
+        for (size_t i = 0; i < columns.size(); i++) {
+            fprintf(fp, "%s%s", i ? "," : "", columns[i].second.c_str());
+        }
+        fprintf(fp, "\n");
+    }
+}
+
+bool megpeak::load_results(const std::string& path, Environment& env,
+                           std::vector<ResultRecord>& records) {
+    std::ifstream fin(path);
+    std::string line;
+    if (!std::getline(fin, line)) {
+        return false;
+    }
+    auto header = split_csv(line);
+    auto expected = fields({}, {}, false);
+    if (header.size() != expected.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < header.size(); i++) {
+        if (header[i] != expected[i].first) {
+            return false;
+        }
+    }
+    records.clear();
+    while (std::getline(fin, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        auto columns = split_csv(line);
+        if (columns.size() != header.size()) {
+            return false;
+        }
+        std::map<std::string, std::string> values;
+        for (size_t i = 0; i < header.size(); i++) {
+            values[header[i]] = columns[i];
+        }
+        if (records.empty()) {
+            env.backend = values["backend"];
+            env.device_id = strtoull(values["device_id"].c_str(), nullptr, 10);
+            env.device_name = values["device_name"];
+            env.cpu_model = values["cpu_model"];
+            env.compiler = values["compiler"];
+            env.build_flags = values["build_flags"];
+            env.kernel_version = values["kernel_version"];
+        }
+        ResultRecord record{values["suite"], values["name"], values["isa"],
+                            values["metric"], values["unit"], {}};
+        auto&& stats = record.stats;
+        std::stringstream samples(values["samples"]);
+        std::string sample;
+        while (std::getline(samples, sample, ';')) {
+            stats.samples.push_back(parse_number(sample));
+        }
+        stats.nr_outliers = strtoull(values["nr_outliers"].c_str(), nullptr, 10);
+        stats.median = parse_number(values["value"]);
+        stats.min = parse_number(values["min"]);
+        stats.max = parse_number(values["max"]);
+        stats.mean = parse_number(values["mean"]);
+        stats.stddev = parse_number(values["stddev"]);
+        stats.p95 = parse_number(values["p95"]);
+        stats.ci_low = parse_number(values["ci95_low"]);
+        stats.ci_high = parse_number(values["ci95_high"]);
+        records.emplace_back(std::move(record));
+    }
+    return true;
+}
+
+bool megpeak::parse_format(const std::string& str, ResultSink::Format& format) {
+    if (str == "json") {
+        format = ResultSink::Format::JSON;
+    } else if (str == "csv") {
+        format = ResultSink::Format::CSV;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+ResultSink* megpeak::get_result_sink() {
+    auto&& options = get_options();
+    if (options.format.empty() && options.save_baseline.empty() &&
+        options.compare.empty()) {
+        return nullptr;
+    }
+    static ResultSink sink;
+    return &sink;
+}
+
+void megpeak::report_result(const std::string& suite, const std::string& name,
+                            const std::string& isa, const std::string& metric,
+                            const std::string& unit, const Statistics& stats) {
+    if (auto sink = get_result_sink()) {
+        sink->add({suite, name, isa, metric, unit, stats});
+    }
+}
+
+void megpeak::report_result(const std::string& suite, const std::string& name,
+                            const std::string& isa, const std::string& metric,
+                            const std::string& unit, double value) {
+    report_result(suite, name, isa, metric, unit, compute_statistics({value}));
+}
+
+std::string megpeak::get_cpu_model() {
+#ifdef __APPLE__
+    char buf[256];
+    size_t size = sizeof(buf);
+    if (sysctlbyname("machdep.cpu.brand_string", buf, &size, nullptr, 0) ==
+        0) {
+        return buf;
+    }
+#else
+    //! x86, loongarch and the android arm kernels
+    for (auto key : {"model name", "Model Name", "Hardware"}) {
+        auto model = read_cpuinfo(key);
+        if (!model.empty()) {
+            return model;
+        }
+    }
+    //! the arm linux kernels only expose the main id register fields
+    auto implementer = read_cpuinfo("CPU implementer");
+    auto part = read_cpuinfo("CPU part");
+    if (!implementer.empty()) {
+        return "implementer " + implementer + " part " + part;
+    }
+#endif
+    return "unknown";
+}
+
+// vim: syntax=cpp.doxygen
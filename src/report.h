@@ -0,0 +1,121 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "src/statistics.h"
+
+namespace megpeak {
+
+//! the machine and the build which produced the results
+struct Environment {
+    //! cpu or opencl
+    std::string backend;
+    //! core id of the cpu backend, device id of the opencl backend
+    size_t device_id = 0;
+    //! cpu model for the cpu backend, device name for the opencl backend
+    std::string device_name;
+    std::string cpu_model;
+    std::string compiler;
+    std::string build_flags;
+    //! uname of the operating system kernel
+    std::string kernel_version;
+};
+
+//! one measured metric of a benchmark
+struct ResultRecord {
+    //! the suite or the opencl runner the benchmark belongs to
+    std::string suite;
+    std::string name;
+    //! isa extension of the benchmark, empty for the baseline isa
+    std::string isa;
+    //! what is measured, e.g. throughput, latency, bandwidth, gflops
+    std::string metric;
+    std::string unit;
+    //! a single measured value is reported as one sample
+    Statistics stats;
+};
+
+/**
+ * \brief machine readable results of the run
+ *
+ * the records are collected during the run and written at the end, every
+ * record is written with the full environment so that each line of the csv
+ * or each object of the json array is self-contained.
+ */
+class ResultSink {
+public:
+    enum class Format { JSON, CSV };
+
+    ResultSink();
+
+    Environment& environment() { return m_env; }
+    const Environment& environment() const { return m_env; }
+    const std::vector<ResultRecord>& records() const { return m_records; }
+    void add(ResultRecord record) {
+        if (!m_scope.empty()) {
+            record.suite = m_scope + "/" + record.suite;
+        }
+        m_records.emplace_back(std::move(record));
+    }
+    //! prefix of the suite of the records added from now on, e.g. the
+    //! cluster of --all-cores, empty for none
+    void set_scope(const std::string& scope) { m_scope = scope; }
+    //! write the records to the output, stdout if the output is empty
+    void write(Format format, const std::string& output) const;
+
+private:
+    void write_json(FILE* fp) const;
+    void write_csv(FILE* fp) const;
+
+    Environment m_env;
+    std::vector<ResultRecord> m_records;
+    std::string m_scope;
+};
+
+//! \return false if the format is not json or csv
+bool parse_format(const std::string& str, ResultSink::Format& format);
+
+/**
+ * \brief read the records of a csv written by ResultSink::write()
+ *
+ * the environment is the one of the first record.
+ * \return false if the file can not be read or is not such a csv
+ */
+bool load_results(const std::string& path, Environment& env,
+                  std::vector<ResultRecord>& records);
+
+/**
+ * \brief the sink of the run
+ *
+ * \return nullptr if the results are not needed, i.e. none of --format,
+ * --save-baseline and --compare is given
+ */
+ResultSink* get_result_sink();
+
+//! add a record to the sink, no-op if there is no sink
+void report_result(const std::string& suite, const std::string& name,
+                   const std::string& isa, const std::string& metric,
+                   const std::string& unit, const Statistics& stats);
+void report_result(const std::string& suite, const std::string& name,
+                   const std::string& isa, const std::string& metric,
+                   const std::string& unit, double value);
+
+//! cpu model name of the host, "unknown" if it can not be detected
+std::string get_cpu_model();
+
+}  // namespace megpeak
+
+// vim: syntax=cpp.doxygen
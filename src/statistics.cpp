@@ -0,0 +1,134 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+
+#include "src/statistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace megpeak;
+
+namespace {
+//! modified z-score threshold, see Iglewicz and Hoaglin
+constexpr double OUTLIER_THRESHOLD = 3.5;
+//! the mad is at least this fraction of the median, samples within a few
+//! percent of the median are noise, not outliers
+constexpr double MIN_RELATIVE_MAD = 0.01;
+//! fewer samples do not tell outliers from the spread
+constexpr size_t MIN_OUTLIER_SAMPLES = 5;
+
+//! two-sided 95% quantile of the student-t distribution, index is dof - 1
+constexpr double T_TABLE_95[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+
+//! \p sorted must be sorted ascending, linear interpolation between ranks
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    double pos = p * (sorted.size() - 1);
+    size_t lo = static_cast<size_t>(std::floor(pos));
+    size_t hi = std::min(lo + 1, sorted.size() - 1);
+    double frac = pos - lo;
+    return sorted[lo] * (1 - frac) + sorted[hi] * frac;
+}
+}  // namespace
+
+double megpeak::t_quantile_95(size_t dof) {
+    constexpr size_t nr_entry = sizeof(T_TABLE_95) / sizeof(T_TABLE_95[0]);
+    if (dof == 0) {
+        return 0;
+    }
+    if (dof <= nr_entry) {
+        return T_TABLE_95[dof - 1];
+    }
+    return 1.96;
+}
+
+bool megpeak::is_testable(const Statistics& lhs, const Statistics& rhs) {
+    return lhs.nr_samples() > 1 && rhs.nr_samples() > 1;
+}
+
+bool megpeak::is_significant(const Statistics& lhs, const Statistics& rhs) {
+    if (!is_testable(lhs, rhs)) {
+        return false;
+    }
+    size_t n1 = lhs.nr_samples(), n2 = rhs.nr_samples();
+    double v1 = lhs.stddev * lhs.stddev / n1;
+    double v2 = rhs.stddev * rhs.stddev / n2;
+    double diff = std::abs(lhs.mean - rhs.mean);
+    if (v1 + v2 == 0) {
+        //! identical samples on both sides, only a different value counts
+        return diff > 0;
+    }
+    //! welch-satterthwaite degrees of freedom
+    double dof = (v1 + v2) * (v1 + v2);
+    double denominator = v1 * v1 / (n1 - 1) + v2 * v2 / (n2 - 1);
+    size_t nr_dof = static_cast<size_t>(std::max(1.0, dof / denominator));
+    return diff / std::sqrt(v1 + v2) > t_quantile_95(nr_dof);
+}
+
+Statistics megpeak::compute_statistics(std::vector<double> samples) {
+    Statistics ret;
+    if (samples.empty()) {
+        return ret;
+    }
+    std::sort(samples.begin(), samples.end());
+    double median = percentile(samples, 0.5);
+
+    //! reject the outliers with the median absolute deviation, which is not
+    //! disturbed by the outliers themselves like the stddev is
+    std::vector<double> deviation(samples.size());
+    for (size_t i = 0; i < samples.size(); i++) {
+        deviation[i] = std::fabs(samples[i] - median);
+    }
+    std::sort(deviation.begin(), deviation.end());
+    double mad = std::max(percentile(deviation, 0.5),
+                          MIN_RELATIVE_MAD * std::fabs(median));
+    if (mad > 0 && samples.size() >= MIN_OUTLIER_SAMPLES) {
+        for (auto x : samples) {
+            double z = 0.6745 * std::fabs(x - median) / mad;
+            if (z > OUTLIER_THRESHOLD) {
+                ret.nr_outliers++;
+            } else {
+                ret.samples.push_back(x);
+            }
+        }
+    } else {
+        ret.samples = samples;
+    }
+
+    auto&& kept = ret.samples;
+    size_t n = kept.size();
+    ret.min = kept.front();
+    ret.max = kept.back();
+    ret.median = percentile(kept, 0.5);
+    ret.p95 = percentile(kept, 0.95);
+
+    double sum = 0;
+    for (auto x : kept) {
+        sum += x;
+    }
+    ret.mean = sum / n;
+    double sq_sum = 0;
+    for (auto x : kept) {
+        sq_sum += (x - ret.mean) * (x - ret.mean);
+    }
+    ret.stddev = n > 1 ? std::sqrt(sq_sum / (n - 1)) : 0;
+    double half_width = t_quantile_95(n - 1) * ret.stddev / std::sqrt(n);
+    ret.ci_low = ret.mean - half_width;
+    ret.ci_high = ret.mean + half_width;
+    return ret;
+}
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,63 @@
+/**
+ * MegPeaK is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2021-2021 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied.
+ */
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace megpeak {
+
+/**
+ * \brief summary of repeated measurements of one quantity
+ *
+ * samples which are too far away from the median (modified z-score larger
+ * than 3.5, with the mad floored at 1% of the median) are rejected as
+ * outliers before mean/stddev/ci are computed, nothing is rejected out of
+ * less than 5 samples. min and max are the extremes of the kept samples.
+ */
+struct Statistics {
+    //! samples kept after the outlier rejection
+    std::vector<double> samples;
+    size_t nr_outliers = 0;
+
+    double min = 0;
+    double max = 0;
+    double median = 0;
+    double mean = 0;
+    double stddev = 0;
+    double p95 = 0;
+    //! 95% confidence interval of the mean, student-t based
+    double ci_low = 0;
+    double ci_high = 0;
+
+    size_t nr_samples() const { return samples.size(); }
+};
+
+Statistics compute_statistics(std::vector<double> samples);
+
+//! two-sided 95% quantile of the student-t distribution
+double t_quantile_95(size_t dof);
+
+//! whether both measurements have the samples for is_significant()
+bool is_testable(const Statistics& lhs, const Statistics& rhs);
+
+/**
+ * \brief whether the means of two measurements differ significantly
+ *
+ * welch's t-test at the 95% level. A measurement with a single sample, e.g.
+ * a value derived from several benchmarks, has no known spread and is never
+ * significant, see is_testable().
+ */
+bool is_significant(const Statistics& lhs, const Statistics& rhs);
+
+}  // namespace megpeak
+
+// vim: syntax=cpp.doxygen